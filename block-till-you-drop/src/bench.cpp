@@ -0,0 +1,261 @@
+// Microbenchmarks for the grid kernels, on synthetic boards, and for
+// drawing and encoding capture frames.
+//
+//   bench [--benchmark_filter=REGEX] [other Google Benchmark flags]
+//
+// Each iteration restores the kernel's inputs from a prepared board first,
+// so timings include a small fixed copy cost; compare runs against each
+// other, not against the per-phase profile. Board arguments are columns,
+// rows: 16x20 and 32x20 take the specialized kernels, 24x30 and 64x64 the
+// generic ones.
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bot.h"
+#include "capture.h"
+#include "framebuffer.h"
+#include "game.h"
+#include "rng.h"
+#include "versus.h"
+
+static const std::uint64_t BENCH_SEED = 12345;
+
+// A cols x rows board with `fillPct` percent of cells occupied uniformly at
+// random below the top row, one tile in twenty a powerup.
+static void fillBoard(GameState &st, int cols, int rows, int fillPct, std::uint64_t seed)
+{
+    st.config.cols = cols;
+    st.config.rows = rows;
+    resetGame(st, seed);
+    Rng rng;
+    rng.seed(seed, 0xbe7c);
+    for (int r = 1; r < rows; ++r)
+        for (int c = 0; c < cols; ++c) {
+            if (rng.below(100) >= fillPct) continue;
+            BlockType t = rng.below(20) == 0 ? (BlockType)(1 + rng.below(4)) : NORMAL;
+            st.grid.set(c, r, t);
+        }
+}
+
+// Drop `n` single-cell, 2x2 and 1x3 shapes into the rows above the stack.
+static void addFallingShapes(GameState &st, int n, std::uint64_t seed)
+{
+    Rng rng;
+    rng.seed(seed, 0x5a9e);
+    for (int k = 0; k < n; ++k) {
+        int kind = rng.below(3);
+        int w = kind == 1 ? 2 : 1, h = kind == 0 ? 1 : kind == 1 ? 2 : 3;
+        if (!st.shapes.canFit(w * h)) break;
+        int col = rng.below(st.grid.width - w + 1);
+        float y = (float)(rng.below(st.grid.height / 2) * CELL + rng.below(CELL));
+        FallingShape &s = st.shapes.push((float)(col * CELL), y, 220.0f);
+        for (int dy = 0; dy < h; ++dy)
+            for (int dx = 0; dx < w; ++dx)
+                st.shapes.addCell(s, dx, dy, NORMAL);
+        st.shapes.findBottomCells(s);
+    }
+}
+
+static void boardSizes(benchmark::internal::Benchmark *b, std::vector<long> third)
+{
+    static const int SIZES[][2] = { {16, 20}, {32, 20}, {24, 30}, {64, 64} };
+    for (const auto &sz : SIZES)
+        for (long v : third) b->Args({ sz[0], sz[1], v });
+}
+
+// Args: cols, rows, fill percent; every cell dirty.
+static void BM_ResolveFloatingClusters(benchmark::State &state)
+{
+    static GameState base, st;
+    fillBoard(base, (int)state.range(0), (int)state.range(1), (int)state.range(2), BENCH_SEED);
+    int pc = base.grid.width / 2, pr = base.grid.height - 1;
+    st = base;
+    for (auto _ : state) {
+        st.grid = base.grid;
+        st.grid.markAllDirty();
+        st.shapes.clear();
+        resolveFloatingClusters(st.grid, st.shapes, 220.0f, pc, pc, pr, pr);
+        benchmark::DoNotOptimize(st.shapes.shapeCount);
+    }
+}
+BENCHMARK(BM_ResolveFloatingClusters)->Apply([](benchmark::internal::Benchmark *b) {
+    boardSizes(b, { 10, 30, 50, 70, 90 });
+});
+
+// A quiet frame: nothing dirty, the common case.
+static void BM_ResolveFloatingClustersClean(benchmark::State &state)
+{
+    static GameState st;
+    fillBoard(st, (int)state.range(0), (int)state.range(1), (int)state.range(2), BENCH_SEED);
+    int pc = st.grid.width / 2, pr = st.grid.height - 1;
+    resolveFloatingClusters(st.grid, st.shapes, 220.0f, pc, pc, pr, pr);
+    for (auto _ : state) {
+        resolveFloatingClusters(st.grid, st.shapes, 220.0f, pc, pc, pr, pr);
+        benchmark::DoNotOptimize(st.grid.dirty);
+    }
+}
+BENCHMARK(BM_ResolveFloatingClustersClean)->Apply([](benchmark::internal::Benchmark *b) {
+    boardSizes(b, { 50 });
+});
+
+// Args: cols, rows, full rows at the bottom of a half-filled board.
+static void BM_ClearFullRows(benchmark::State &state)
+{
+    static GameState base;
+    fillBoard(base, (int)state.range(0), (int)state.range(1), 50, BENCH_SEED);
+    for (int r = base.grid.height - (int)state.range(2); r < base.grid.height; ++r)
+        for (int c = 0; c < base.grid.width; ++c) base.grid.set(c, r, NORMAL);
+    static Grid grid;
+    for (auto _ : state) {
+        grid = base.grid;
+        benchmark::DoNotOptimize(clearFullRows(grid));
+    }
+}
+BENCHMARK(BM_ClearFullRows)->Apply([](benchmark::internal::Benchmark *b) {
+    boardSizes(b, { 0, 1, 4, 16 });
+});
+
+// Args: cols, rows, BlockType of the power, fired mid-board with shapes in
+// the air.
+static void BM_ApplyPower(benchmark::State &state)
+{
+    static GameState base, st;
+    fillBoard(base, (int)state.range(0), (int)state.range(1), 60, BENCH_SEED);
+    addFallingShapes(base, 24, BENCH_SEED);
+    BlockType type = (BlockType)state.range(2);
+    st = base;
+    for (auto _ : state) {
+        st.grid = base.grid;
+        st.shapes = base.shapes;
+        applyPower(st, type, base.grid.width / 2, base.grid.height / 2);
+        benchmark::DoNotOptimize(st.grid.count);
+    }
+}
+BENCHMARK(BM_ApplyPower)->Apply([](benchmark::internal::Benchmark *b) {
+    boardSizes(b, { BOMB, LASER_H, LASER_V });
+});
+
+// Args: cols, rows, shapes in the air over a 40% board; one tick of the
+// landing loop.
+static void BM_UpdateFallingShapes(benchmark::State &state)
+{
+    static GameState base, st;
+    fillBoard(base, (int)state.range(0), (int)state.range(1), 40, BENCH_SEED);
+    addFallingShapes(base, (int)state.range(2), BENCH_SEED);
+    st = base;
+    for (auto _ : state) {
+        st.grid = base.grid;
+        st.shapes = base.shapes;
+        updateFallingShapes(st, TICK_DT);
+        benchmark::DoNotOptimize(st.shapes.shapeCount);
+    }
+}
+BENCHMARK(BM_UpdateFallingShapes)->Apply([](benchmark::internal::Benchmark *b) {
+    boardSizes(b, { 4, 16, 64 });
+});
+
+// Args: cols, rows. Whole ticks of a bot-free game, for context.
+static void BM_Step(benchmark::State &state)
+{
+    static GameState st;
+    st.config.cols = (int)state.range(0);
+    st.config.rows = (int)state.range(1);
+    resetGame(st, BENCH_SEED);
+    for (auto _ : state) {
+        if (st.gameOver) resetGame(st, BENCH_SEED);
+        benchmark::DoNotOptimize(step(st, 0, TICK_DT));
+    }
+}
+BENCHMARK(BM_Step)->Args({ 16, 20 })->Args({ 32, 20 })->Args({ 24, 30 })->Args({ 64, 64 });
+
+// Args: cols, rows. Saving a mid-game state, as rollback does every tick.
+static void BM_CopyGameState(benchmark::State &state)
+{
+    static GameState st, snap;
+    st.config.cols = (int)state.range(0);
+    st.config.rows = (int)state.range(1);
+    resetGame(st, BENCH_SEED);
+    for (int t = 0; t < 10 * TICK_RATE && !st.gameOver; ++t) step(st, 0, TICK_DT);
+    for (auto _ : state) {
+        copyGameState(snap, st);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_CopyGameState)->Args({ 16, 20 })->Args({ 64, 64 });
+
+// Args: cols, rows. A worst-case versus rollback: restore a mid-match
+// state and re-simulate both boards for the whole prediction window.
+static void BM_VersusRollback(benchmark::State &state)
+{
+    static VersusState base, vs;
+    GameConfig cfg;
+    cfg.cols = (int)state.range(0);
+    cfg.rows = (int)state.range(1);
+    resetVersus(base, cfg, BENCH_SEED);
+    Rng rng;
+    rng.seed(BENCH_SEED, 0x7e55);
+    for (int t = 0; t < 10 * TICK_RATE && base.winner < 0; ++t)
+        stepVersus(base, (InputMask)rng.below(128), (InputMask)rng.below(128));
+    for (auto _ : state) {
+        vs = base;
+        for (int t = 0; t < RollbackSession::MAX_PREDICTION; ++t) stepVersus(vs, 0, 0);
+        benchmark::DoNotOptimize(vs.tick);
+    }
+}
+BENCHMARK(BM_VersusRollback)->Args({ 16, 20 })->Args({ 32, 20 })->Args({ 64, 64 });
+
+// Args: beam width, depth. One bot decision from a mid-game state on one
+// thread, with no time budget.
+static void BM_BotPlan(benchmark::State &state)
+{
+    static GameState st;
+    st.config = GameConfig{};
+    resetGame(st, BENCH_SEED);
+    for (int t = 0; t < 20 * TICK_RATE && !st.gameOver; ++t) step(st, 0, TICK_DT);
+    BotConfig cfg;
+    cfg.beamWidth = (int)state.range(0);
+    cfg.depth     = (int)state.range(1);
+    Bot bot(cfg);
+    for (auto _ : state) {
+        bot.reset(BENCH_SEED);      // drop the plan, so act() searches
+        benchmark::DoNotOptimize(bot.act(st));
+    }
+}
+BENCHMARK(BM_BotPlan)->Args({ 8, 1 })->Args({ 8, 3 })->Unit(benchmark::kMicrosecond);
+
+// Args: cols, rows. One software-rasterized frame of a half-full board
+// with falling shapes, as the framebuffer backend and replay export draw it.
+static void BM_DrawPlayfieldPixels(benchmark::State &state)
+{
+    static GameState st;
+    fillBoard(st, (int)state.range(0), (int)state.range(1), 50, BENCH_SEED);
+    addFallingShapes(st, 20, BENCH_SEED);
+    Image img;
+    img.resize(st.grid.pixelWidth(), st.grid.pixelHeight());
+    Framebuffer fb = img.view();
+    for (auto _ : state) {
+        drawPlayfieldPixels(fb, st, 0.5f);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_DrawPlayfieldPixels)->Args({ 16, 20 })->Args({ 64, 64 })->Unit(benchmark::kMicrosecond);
+
+// Args: cols, rows. PNG encoding of the frame above.
+static void BM_EncodePng(benchmark::State &state)
+{
+    static GameState st;
+    fillBoard(st, (int)state.range(0), (int)state.range(1), 50, BENCH_SEED);
+    addFallingShapes(st, 20, BENCH_SEED);
+    Image img;
+    img.resize(st.grid.pixelWidth(), st.grid.pixelHeight());
+    Framebuffer fb = img.view();
+    drawPlayfieldPixels(fb, st, 0.5f);
+    std::size_t bytes = 0;
+    for (auto _ : state) bytes = encodePng(img).size();
+    state.counters["bytes"] = (double)bytes;
+}
+BENCHMARK(BM_EncodePng)->Args({ 16, 20 })->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+#include "bot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+// Action 0 holds nothing, so among equally good plans the bot stands still.
+static InputMask actionInput(int action)
+{
+    static const InputMask MOVE[3]  = { 0, INPUT_LEFT, INPUT_RIGHT };
+    static const InputMask BREAK[5] = { 0, INPUT_BREAK_LEFT, INPUT_BREAK_RIGHT,
+                                        INPUT_BREAK_UP, INPUT_BREAK_DOWN };
+    InputMask in = MOVE[action % 3] | BREAK[action / 6];
+    if ((action / 3) % 2) in |= INPUT_JUMP;
+    return in;
+}
+
+// Higher is better. Losing is worst, later losses less so; otherwise every
+// tile costs, the more the nearer it is to the top, and so do the cells
+// still falling.
+static double evaluate(const GameState &st)
+{
+    if (st.gameOver) return -1e9 + (double)st.tick;
+
+    const Grid &grid = st.grid;
+    double score = -(double)st.shapes.cellCount;
+    for (int r = 0; r < grid.height; ++r) {
+        if (!grid.rows[r]) continue;
+        double up = (double)(grid.height - r) / grid.height;
+        score -= popcount64(grid.rows[r]) * (1.0 + 24.0 * up * up * up);
+    }
+    return score;
+}
+
+Bot::Bot(const BotConfig &config)
+    : cfg(config), workers(std::max(1, config.threads))
+{
+    cfg.beamWidth = std::max(1, cfg.beamWidth);
+    cfg.depth     = std::max(1, cfg.depth);
+    cfg.holdTicks = std::max(1, cfg.holdTicks);
+    // Sized once; searching allocates nothing.
+    beam.resize(cfg.beamWidth);
+    next.resize(cfg.beamWidth);
+    scratch.resize(workers.size());
+    candidates.resize(cfg.beamWidth * ACTIONS);
+    reset(0);
+}
+
+void Bot::reset(std::uint64_t seed)
+{
+    planRng.seed(seed, 0xb07);
+    current = 0;
+    ticksLeft = 0;
+}
+
+InputMask Bot::act(const GameState &st)
+{
+    if (st.gameOver) return 0;
+    if (ticksLeft <= 0) {
+        current = actionInput(plan(st));
+        ticksLeft = cfg.holdTicks;
+    }
+    --ticksLeft;
+    return current;
+}
+
+void Bot::simulate(GameState &st, int action) const
+{
+    InputMask in = actionInput(action);
+    for (int t = 0; t < cfg.holdTicks && !st.gameOver; ++t) step(st, in, TICK_DT);
+}
+
+// Returns the first action of the best plan.
+int Bot::plan(const GameState &root)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(cfg.budgetMs));
+
+    Node &origin = beam[0];
+    copyGameState(origin.state, root);
+    origin.state.rng.seed(((std::uint64_t)planRng.next() << 32) | planRng.next());
+    // Keep only the previewed spawn, which a player can see too; the rest
+    // of the queue is redrawn from the made-up stream.
+    if (origin.state.spawnCount > 1) origin.state.spawnCount = 1;
+    origin.firstAction = 0;
+    int beamSize = 1;
+    int best = 0;
+    searchedDepth = 0;
+
+    for (int d = 0; d < cfg.depth; ++d) {
+        const int n = beamSize * ACTIONS;
+        std::atomic<bool> late{ false };
+        auto expand = [&](int i, int w) {
+            if (d > 0 && cfg.budgetMs > 0.0 &&
+                (late.load(std::memory_order_relaxed) || Clock::now() > deadline)) {
+                late.store(true, std::memory_order_relaxed);
+                return;
+            }
+            GameState &s = scratch[w];
+            copyGameState(s, beam[i / ACTIONS].state);
+            simulate(s, i % ACTIONS);
+            candidates[i] = Candidate{ evaluate(s), i };
+        };
+        workers.run(n, expand);
+        if (late.load()) break;
+
+        // Best first; ties go to the lower index so the thread count never
+        // changes the choice.
+        const int keep = std::min(cfg.beamWidth, n);
+        std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.begin() + n,
+                          [](const Candidate &a, const Candidate &b) {
+                              return a.score != b.score ? a.score > b.score : a.index < b.index;
+                          });
+        const Candidate &top = candidates[0];
+        best = d == 0 ? top.index % ACTIONS : beam[top.index / ACTIONS].firstAction;
+        searchedDepth = d + 1;
+        if (d + 1 == cfg.depth) break;
+
+        // Re-simulate the survivors for the next level rather than keeping
+        // every candidate's state around.
+        auto grow = [&](int k, int) {
+            const Candidate &c = candidates[k];
+            const Node &parent = beam[c.index / ACTIONS];
+            Node &child = next[k];
+            copyGameState(child.state, parent.state);
+            simulate(child.state, c.index % ACTIONS);
+            child.firstAction = d == 0 ? c.index % ACTIONS : parent.firstAction;
+        };
+        workers.run(keep, grow);
+        beam.swap(next);
+        beamSize = keep;
+    }
+
+    searchMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return best;
+}
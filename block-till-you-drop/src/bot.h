@@ -0,0 +1,76 @@
+#pragma once
+
+// Built-in player for attract mode and balance runs. It produces the same
+// InputMask the keyboard does, one tick at a time.
+//
+// Every holdTicks ticks it re-plans with a beam search over "macro"
+// actions: one of ACTIONS button sets held for holdTicks ticks. Each
+// candidate is a copy of the game stepped through the real engine, so moves,
+// jumps, breaks and powerups all behave exactly as in play. Candidates are
+// scored by how much stack they leave, weighted towards the top, and the
+// best beamWidth go on to the next level. The first action of the best plan
+// found is the one played.
+//
+// Search copies get their own Rng, so beyond the previewed next shape the
+// bot plans against made-up spawns rather than the ones the game is about
+// to produce.
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+#include "parallel.h"
+#include "rng.h"
+
+struct BotConfig {
+    int    beamWidth = 8;
+    int    depth     = 3;       // levels of lookahead
+    int    holdTicks = 15;      // per action, 125 ms
+    int    threads   = 1;
+    // Stop deepening once a search has taken this long; the first level
+    // always completes. 0 searches the full depth, which keeps the bot's
+    // choices independent of machine speed and thread count.
+    double budgetMs  = 0.0;
+};
+
+class Bot {
+public:
+    // Move (none, left, right) x jump x break (none or one of four arrows).
+    static const int ACTIONS = 3 * 2 * 5;
+
+    explicit Bot(const BotConfig &config = BotConfig());
+
+    // Forget the current plan; seed drives the made-up spawns.
+    void reset(std::uint64_t seed);
+
+    // Input for the next tick of st.
+    InputMask act(const GameState &st);
+
+    // Last search: levels completed and wall time.
+    int    lastDepth() const { return searchedDepth; }
+    double lastSearchMs() const { return searchMs; }
+
+private:
+    struct Node {
+        GameState state;
+        int       firstAction;
+    };
+    struct Candidate {
+        double score;
+        int    index;               // parent * ACTIONS + action
+    };
+
+    int  plan(const GameState &st);
+    void simulate(GameState &st, int action) const;
+
+    BotConfig  cfg;
+    WorkerPool workers;
+    Rng        planRng;
+    std::vector<Node>      beam, next;
+    std::vector<GameState> scratch;          // one per worker
+    std::vector<Candidate> candidates;
+    InputMask current = 0;
+    int    ticksLeft = 0;
+    int    searchedDepth = 0;
+    double searchMs = 0.0;
+};
@@ -0,0 +1,285 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ===== Deflate, fixed Huffman codes only =====
+
+namespace {
+
+// Bits go out least significant first, as deflate packs them.
+struct BitWriter {
+    std::vector<std::uint8_t> &out;
+    std::uint32_t acc = 0;
+    int bits = 0;
+
+    explicit BitWriter(std::vector<std::uint8_t> &o) : out(o) {}
+
+    void put(std::uint32_t v, int n) {
+        acc |= v << bits;
+        bits += n;
+        while (bits >= 8) {
+            out.push_back((std::uint8_t)acc);
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+    // Huffman codes are defined most significant bit first.
+    void putCode(std::uint32_t code, int n) {
+        std::uint32_t r = 0;
+        for (int i = 0; i < n; ++i, code >>= 1) r = (r << 1) | (code & 1u);
+        put(r, n);
+    }
+    void flush() {
+        if (bits > 0) out.push_back((std::uint8_t)acc);
+        acc = 0;
+        bits = 0;
+    }
+};
+
+} // namespace
+
+static const int LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const int DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Literal/length symbol in the fixed code.
+static void putSymbol(BitWriter &bw, int sym)
+{
+    if      (sym < 144) bw.putCode(0x30 + sym, 8);
+    else if (sym < 256) bw.putCode(0x190 + (sym - 144), 9);
+    else if (sym < 280) bw.putCode(sym - 256, 7);
+    else                bw.putCode(0xc0 + (sym - 280), 8);
+}
+
+static void putMatch(BitWriter &bw, int len, int dist)
+{
+    int l = 28;
+    while (LEN_BASE[l] > len) --l;
+    putSymbol(bw, 257 + l);
+    bw.put((std::uint32_t)(len - LEN_BASE[l]), LEN_EXTRA[l]);
+
+    int d = 29;
+    while (DIST_BASE[d] > dist) --d;
+    bw.putCode((std::uint32_t)d, 5);
+    bw.put((std::uint32_t)(dist - DIST_BASE[d]), DIST_EXTRA[d]);
+}
+
+// One final fixed-code block. Greedy LZ77 over a 32 KB window with a short
+// hash chain: plenty for flat-coloured frames.
+static void deflateFixed(const std::uint8_t *data, int n, std::vector<std::uint8_t> &out)
+{
+    const int WINDOW = 32768;
+    const int HASH_BITS = 15;
+    const int MAX_CHAIN = 16;
+    const int MAX_MATCH = 258;
+
+    std::vector<int> head(1u << HASH_BITS, -1), prev(WINDOW, -1);
+    auto hash = [&](int i) {
+        std::uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](int i) {
+        if (i + 3 > n) return;
+        std::uint32_t h = hash(i);
+        prev[i & (WINDOW - 1)] = head[h];
+        head[h] = i;
+    };
+
+    BitWriter bw(out);
+    bw.put(1, 1);       // final block
+    bw.put(1, 2);       // fixed Huffman codes
+    for (int i = 0; i < n; ) {
+        int bestLen = 0, bestDist = 0;
+        if (i + 3 <= n) {
+            const int maxLen = std::min(MAX_MATCH, n - i);
+            int cand = head[hash(i)];
+            for (int chain = 0; cand >= 0 && i - cand <= WINDOW && chain < MAX_CHAIN; ++chain) {
+                int len = 0;
+                while (len < maxLen && data[cand + len] == data[i + len]) ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = i - cand;
+                    if (len == maxLen) break;
+                }
+                int next = prev[cand & (WINDOW - 1)];
+                if (next >= cand) break;         // slot reused by a newer position
+                cand = next;
+            }
+        }
+        if (bestLen >= 3) {
+            putMatch(bw, bestLen, bestDist);
+            // Hashing every position inside a long run buys nothing: the
+            // run's own tail is the best source for whatever follows.
+            for (int k = bestLen > 32 ? bestLen - 2 : 0; k < bestLen; ++k) insert(i + k);
+            i += bestLen;
+        } else {
+            putSymbol(bw, data[i]);
+            insert(i);
+            ++i;
+        }
+    }
+    putSymbol(bw, 256);
+    bw.flush();
+}
+
+// ===== PNG =====
+
+static std::uint32_t crc32(const std::uint8_t *p, std::size_t n, std::uint32_t crc = 0)
+{
+    static const struct Table {
+        std::uint32_t v[256];
+        Table() {
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1u) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (std::size_t i = 0; i < n; ++i) crc = table.v[(crc ^ p[i]) & 0xffu] ^ (crc >> 8);
+    return ~crc;
+}
+
+static std::uint32_t adler32(const std::uint8_t *p, std::size_t n)
+{
+    std::uint32_t a = 1, b = 0;
+    while (n > 0) {
+        std::size_t chunk = std::min<std::size_t>(n, 5552);   // no overflow before the mod
+        for (std::size_t i = 0; i < chunk; ++i) {
+            a += p[i];
+            b += a;
+        }
+        a %= 65521u;
+        b %= 65521u;
+        p += chunk;
+        n -= chunk;
+    }
+    return (b << 16) | a;
+}
+
+static void putBE32(std::vector<std::uint8_t> &out, std::uint32_t v)
+{
+    out.push_back((std::uint8_t)(v >> 24));
+    out.push_back((std::uint8_t)(v >> 16));
+    out.push_back((std::uint8_t)(v >> 8));
+    out.push_back((std::uint8_t)v);
+}
+
+static void putChunk(std::vector<std::uint8_t> &out, const char type[4],
+                     const std::uint8_t *data, std::size_t size)
+{
+    putBE32(out, (std::uint32_t)size);
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    putBE32(out, crc32(out.data() + start, size + 4));
+}
+
+std::vector<std::uint8_t> encodePng(const Image &img)
+{
+    const int w = img.width, h = img.height;
+    const std::size_t rowBytes = (std::size_t)w * 3;
+
+    // Filter byte 2 ("Up") on every row: each byte minus the one above.
+    std::vector<std::uint8_t> raw((rowBytes + 1) * (std::size_t)h);
+    for (int y = 0; y < h; ++y) {
+        std::uint8_t *row = &raw[(rowBytes + 1) * (std::size_t)y];
+        const std::uint32_t *px = img.pixels.data() + (std::size_t)y * w;
+        const std::uint32_t *above = y > 0 ? px - w : nullptr;
+        row[0] = 2;
+        for (int x = 0; x < w; ++x) {
+            std::uint32_t c = px[x], u = above ? above[x] : 0;
+            row[1 + 3 * x] = (std::uint8_t)((c >> 16) - (u >> 16));
+            row[2 + 3 * x] = (std::uint8_t)((c >> 8) - (u >> 8));
+            row[3 + 3 * x] = (std::uint8_t)(c - u);
+        }
+    }
+
+    std::vector<std::uint8_t> zlib = { 0x78, 0x01 };
+    deflateFixed(raw.data(), (int)raw.size(), zlib);
+    putBE32(zlib, adler32(raw.data(), raw.size()));
+
+    static const std::uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    std::vector<std::uint8_t> out(SIGNATURE, SIGNATURE + 8);
+    std::vector<std::uint8_t> ihdr;
+    putBE32(ihdr, (std::uint32_t)w);
+    putBE32(ihdr, (std::uint32_t)h);
+    const std::uint8_t rest[5] = { 8, 2, 0, 0, 0 };   // 8-bit RGB, no interlace
+    ihdr.insert(ihdr.end(), rest, rest + 5);
+    putChunk(out, "IHDR", ihdr.data(), ihdr.size());
+    putChunk(out, "IDAT", zlib.data(), zlib.size());
+    putChunk(out, "IEND", nullptr, 0);
+    return out;
+}
+
+bool writePng(const char *path, const Image &img)
+{
+    std::vector<std::uint8_t> data = encodePng(img);
+    std::FILE *f = std::fopen(path, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+// ===== YUV4MPEG2 =====
+
+Y4mWriter::~Y4mWriter()
+{
+    close();
+}
+
+bool Y4mWriter::open(const char *path, int w, int h, int fps)
+{
+    close();
+    ownsFile = std::strcmp(path, "-") != 0;
+    file = ownsFile ? std::fopen(path, "wb") : stdout;
+    if (!file) return false;
+    width = w;
+    height = h;
+    planes.resize((std::size_t)w * h * 3);
+    ok = std::fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", w, h, fps) > 0;
+    return ok;
+}
+
+bool Y4mWriter::write(const Image &img)
+{
+    if (!file || !ok || img.width != width || img.height != height) return false;
+
+    // BT.601, studio range, which is what players assume for y4m.
+    const std::size_t n = (std::size_t)width * height;
+    std::uint8_t *yp = planes.data(), *up = yp + n, *vp = up + n;
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint32_t c = img.pixels[i];
+        int r = (c >> 16) & 0xff, g = (c >> 8) & 0xff, b = c & 0xff;
+        yp[i] = (std::uint8_t)((( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16);
+        up[i] = (std::uint8_t)(((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+        vp[i] = (std::uint8_t)(((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+    }
+    ok = std::fputs("FRAME\n", file) >= 0 &&
+         std::fwrite(planes.data(), 1, planes.size(), file) == planes.size();
+    return ok;
+}
+
+bool Y4mWriter::close()
+{
+    if (!file) return ok;
+    if (std::fflush(file) != 0) ok = false;
+    if (ownsFile && std::fclose(file) != 0) ok = false;
+    file = nullptr;
+    return ok;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Encoders for frames drawn by the software rasterizer, so replays can be
+// turned into stills and video without a window or any libraries.
+//
+// PNG: 8-bit RGB, every row "Up"-filtered and deflated with the fixed
+// Huffman codes. Playfield frames are large flat areas, which this packs to
+// a few KB.
+//
+// Video: a YUV4MPEG2 (.y4m) stream, 4:4:4 so single-pixel outlines keep
+// their colour. Anything ffmpeg-based reads it; with "-" as the path it
+// goes to stdout, e.g. `... --video - | ffmpeg -i - game.mp4`.
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "framebuffer.h"
+
+std::vector<std::uint8_t> encodePng(const Image &img);
+
+// False if the file cannot be written.
+bool writePng(const char *path, const Image &img);
+
+class Y4mWriter {
+public:
+    Y4mWriter() = default;
+    ~Y4mWriter();
+    Y4mWriter(const Y4mWriter &) = delete;
+    Y4mWriter &operator=(const Y4mWriter &) = delete;
+
+    // Start a w x h stream at fps frames per second; "-" is stdout.
+    bool open(const char *path, int w, int h, int fps);
+
+    // Append one frame of the size given to open(). False once writing
+    // has failed.
+    bool write(const Image &img);
+
+    // Flush and close; also done by the destructor. False if any write
+    // failed.
+    bool close();
+
+private:
+    std::FILE *file = nullptr;
+    bool ownsFile = false;
+    bool ok = false;
+    int  width = 0, height = 0;
+    std::vector<std::uint8_t> planes;    // Y, then U, then V
+};
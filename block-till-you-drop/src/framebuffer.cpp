@@ -0,0 +1,166 @@
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+static const int TILE_TYPES = LASER_V + 1;
+
+static const Rgb BACKGROUND    = { 10, 10, 25 };
+static const int PREVIEW_ALPHA = 70;
+
+Rgb tileColor(BlockType type, bool falling)
+{
+    static const Rgb staticFill[TILE_TYPES] = {
+        { 80,160,255}, {200, 40, 40}, {120,200,255},
+        {240,240,100}, {180,255,140}
+    };
+    static const Rgb fallingFill[TILE_TYPES] = {
+        {200, 80, 80}, {230, 60, 60}, {150,220,255},
+        {255,255,150}, {200,255,160}
+    };
+    return falling ? fallingFill[type] : staticFill[type];
+}
+
+static void fillRow(std::uint32_t *p, int n, std::uint32_t v)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i v4 = _mm_set1_epi32((int)v);
+    for (; n >= 8; n -= 8, p += 8) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p),     v4);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 4), v4);
+    }
+#endif
+    for (; n > 0; --n) *p++ = v;
+}
+
+void fillPixels(Framebuffer &fb, int x, int y, int w, int h, std::uint32_t argb)
+{
+    int x0 = std::max(x, 0), x1 = std::min(x + w, fb.width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, fb.height);
+    if (x0 >= x1 || y0 >= y1) return;
+    for (int r = y0; r < y1; ++r)
+        fillRow(fb.pixels + (std::size_t)r * fb.stride + x0, x1 - x0, argb);
+}
+
+// src over dst at a fixed alpha, for the spawn outline.
+static void blendPixels(Framebuffer &fb, int x, int y, int w, int h, Rgb c, int alpha)
+{
+    int x0 = std::max(x, 0), x1 = std::min(x + w, fb.width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, fb.height);
+    const int keep = 255 - alpha;
+    const std::uint32_t sr = c.r * alpha, sg = c.g * alpha, sb = c.b * alpha;
+    for (int r = y0; r < y1; ++r) {
+        std::uint32_t *p = fb.pixels + (std::size_t)r * fb.stride;
+        for (int col = x0; col < x1; ++col) {
+            std::uint32_t d = p[col];
+            std::uint32_t dr = (d >> 16) & 0xff, dg = (d >> 8) & 0xff, db = d & 0xff;
+            p[col] = 0xff000000u |
+                     (((sr + dr * keep) / 255) << 16) |
+                     (((sg + dg * keep) / 255) << 8) |
+                     ((sb + db * keep) / 255);
+        }
+    }
+}
+
+// Every tile drawn once, in the same shapes drawTile() gives the SDL
+// renderer, so a board cell is CELL row copies.
+struct TilePixels {
+    std::uint32_t px[TILE_TYPES][2][CELL * CELL];
+};
+
+static TilePixels bakeTiles()
+{
+    TilePixels t;
+    for (int type = 0; type < TILE_TYPES; ++type)
+        for (int falling = 0; falling < 2; ++falling) {
+            Framebuffer fb{ t.px[type][falling], CELL, CELL, CELL };
+            fillPixels(fb, 0, 0, CELL, CELL, packPixel(tileColor((BlockType)type, falling != 0)));
+            const int mid = CELL / 2;
+            switch (type) {
+                case BOMB: {
+                    int m = CELL / 4;
+                    fillPixels(fb, m, m, CELL - 2 * m, CELL - 2 * m, packPixel(Rgb{ 40, 40, 40 }));
+                    break;
+                }
+                case FREEZE:
+                    // Two lines, endpoints included like SDL_RenderDrawLine.
+                    fillPixels(fb, mid - CELL / 3, mid, 2 * (CELL / 3) + 1, 1, 0xffffffffu);
+                    fillPixels(fb, mid, mid - CELL / 3, 1, 2 * (CELL / 3) + 1, 0xffffffffu);
+                    break;
+                case LASER_H:
+                    fillPixels(fb, 2, mid - 2, CELL - 4, 4, packPixel(Rgb{ 255, 50, 50 }));
+                    break;
+                case LASER_V:
+                    fillPixels(fb, mid - 2, 2, 4, CELL - 4, packPixel(Rgb{ 255, 50, 50 }));
+                    break;
+                default:
+                    break;
+            }
+        }
+    return t;
+}
+
+static const TilePixels &tilePixels()
+{
+    static const TilePixels tiles = bakeTiles();
+    return tiles;
+}
+
+static void copyTile(Framebuffer &fb, const std::uint32_t *tile, int x, int y)
+{
+    int x0 = std::max(x, 0), x1 = std::min(x + CELL, fb.width);
+    int y0 = std::max(y, 0), y1 = std::min(y + CELL, fb.height);
+    if (x0 >= x1 || y0 >= y1) return;
+    const std::size_t bytes = (std::size_t)(x1 - x0) * sizeof(std::uint32_t);
+    for (int r = y0; r < y1; ++r)
+        std::memcpy(fb.pixels + (std::size_t)r * fb.stride + x0,
+                    tile + (r - y) * CELL + (x0 - x), bytes);
+}
+
+void drawPlayfieldPixels(Framebuffer &fb, const GameState &st, float alpha)
+{
+    const TilePixels &tiles = tilePixels();
+    const Grid &grid = st.grid;
+    const ShapePool &pool = st.shapes;
+
+    fillPixels(fb, 0, 0, fb.width, fb.height, packPixel(BACKGROUND));
+
+    for (int row = 0; row < grid.height; ++row)
+        for (RowMask m = grid.rows[row]; m; m &= m - 1) {
+            int col = ctz64(m);
+            copyTile(fb, tiles.px[grid.types[row][col]][0], col * CELL, row * CELL);
+        }
+
+    for (int k = 0; k < pool.shapeCount; ++k) {
+        const FallingShape &s = pool.shapes[k];
+        const float y = s.prevY + (s.y - s.prevY) * alpha;
+        for (int i = s.first; i < s.first + s.count; ++i) {
+            ShapeCell cell = pool.cells[i];
+            copyTile(fb, tiles.px[cellType(cell)][1],
+                     (int)(s.x + cellDx(cell) * CELL), (int)(y + cellDy(cell) * CELL));
+        }
+    }
+
+    const SpawnSpec *next = nextSpawn(st);
+    if (next && !st.gameOver) {
+        const Rgb white = { 255, 255, 255 };
+        const int side = CELL - 4;
+        for (int dy = 0; dy < next->h; ++dy)
+            for (int dx = 0; dx < next->w; ++dx) {
+                int x = (next->col + dx) * CELL + 2, y = dy * CELL + 2;
+                blendPixels(fb, x, y,            side, 1,        white, PREVIEW_ALPHA);
+                blendPixels(fb, x, y + side - 1, side, 1,        white, PREVIEW_ALPHA);
+                blendPixels(fb, x, y + 1,            1, side - 2, white, PREVIEW_ALPHA);
+                blendPixels(fb, x + side - 1, y + 1, 1, side - 2, white, PREVIEW_ALPHA);
+            }
+    }
+
+    fillPixels(fb,
+               st.prevPlayerX + (int)std::lround((st.player.x - st.prevPlayerX) * alpha),
+               st.prevPlayerY + (int)std::lround((st.player.y - st.prevPlayerY) * alpha),
+               st.player.w, st.player.h, packPixel(PLAYER_COLOR));
+}
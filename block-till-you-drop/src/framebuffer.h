@@ -0,0 +1,55 @@
+#pragma once
+
+// Software rasterizer for the playfield, for machines where SDL falls back
+// to its software renderer and for offscreen capture. It writes 32-bit
+// 0xAARRGGBB pixels (SDL_PIXELFORMAT_ARGB8888) straight into memory: rows
+// are filled with wide stores and tiles are copied from pre-drawn pixel
+// rows, instead of going through a draw call per rect. No SDL dependency.
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+// Pixels to draw into, e.g. a locked streaming texture or an Image.
+struct Framebuffer {
+    std::uint32_t *pixels;
+    int width, height;
+    int stride;                      // pixels from one row to the next
+};
+
+// A framebuffer that owns its pixels.
+struct Image {
+    int width = 0, height = 0;
+    std::vector<std::uint32_t> pixels;
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.resize((std::size_t)w * h);
+    }
+    Framebuffer view() { return Framebuffer{ pixels.data(), width, height, width }; }
+};
+
+struct Rgb {
+    std::uint8_t r, g, b;
+};
+
+// Tile body colour; the SDL renderer draws with the same palette.
+Rgb tileColor(BlockType type, bool falling);
+
+static const Rgb PLAYER_COLOR = { 0, 255, 180 };
+
+inline std::uint32_t packPixel(Rgb c) {
+    return 0xff000000u | ((std::uint32_t)c.r << 16) | ((std::uint32_t)c.g << 8) | c.b;
+}
+
+// Solid rect, clipped to the framebuffer.
+void fillPixels(Framebuffer &fb, int x, int y, int w, int h, std::uint32_t argb);
+
+// The whole playfield, looking as the SDL renderer draws it: background,
+// static stack, falling shapes at `alpha` between ticks, the next-spawn
+// outline and the player. Every pixel is written, so fb may start out
+// with any contents. fb is normally st.grid.pixelWidth() x pixelHeight();
+// anything beyond it is clipped.
+void drawPlayfieldPixels(Framebuffer &fb, const GameState &st, float alpha);
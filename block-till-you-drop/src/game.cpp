@@ -0,0 +1,913 @@
+#include "game.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+void ShapePool::findBottomCells(FallingShape &s)
+{
+    // Offsets are non-negative and stay within the board's size; only the
+    // columns the shape spans need clearing.
+    ColMask colBits[MAX_COLS];
+    int end = s.first + s.count;
+    int width = 0;
+    for (int i = s.first; i < end; ++i) width = std::max(width, cellDx(cells[i]) + 1);
+    for (int c = 0; c < width; ++c) colBits[c] = 0;
+    for (int i = s.first; i < end; ++i)
+        colBits[cellDx(cells[i])] |= (ColMask)1u << cellDy(cells[i]);
+
+    // Partition in place: bottom-facing cells to the front.
+    int lo = s.first, hi = end;
+    while (lo < hi) {
+        if (!((colBits[cellDx(cells[lo])] >> cellDy(cells[lo]) >> 1) & 1u)) { ++lo; continue; }
+        --hi;
+        std::swap(cells[lo], cells[hi]);
+    }
+    s.bottomCount = (std::uint16_t)(lo - s.first);
+}
+
+void ShapePool::compact()
+{
+    int ws = 0, wc = 0;
+    for (int k = 0; k < shapeCount; ++k) {
+        FallingShape s = shapes[k];
+        if (s.count == 0) continue;
+        // Ranges are ascending, so this only ever moves cells down.
+        if (s.first != wc) {
+            std::memmove(cells + wc, cells + s.first, (std::size_t)s.count * sizeof(ShapeCell));
+            s.first = (std::uint16_t)wc;
+        }
+        wc += s.count;
+        shapes[ws++] = s;
+    }
+    shapeCount = ws;
+    cellCount  = wc;
+}
+
+void ShapePool::copyFrom(const ShapePool &other)
+{
+    shapeCount = other.shapeCount;
+    cellCount  = other.cellCount;
+    std::memcpy(shapes, other.shapes, (std::size_t)shapeCount * sizeof(FallingShape));
+    std::memcpy(cells, other.cells, (std::size_t)cellCount * sizeof(ShapeCell));
+}
+
+void Grid::copyFrom(const Grid &other)
+{
+    // Everything but the type plane is a few hundred bytes of masks.
+    const std::size_t typesBegin = offsetof(Grid, types);
+    const std::size_t typesEnd   = typesBegin + sizeof(types);
+    unsigned char *d = reinterpret_cast<unsigned char *>(this);
+    const unsigned char *s = reinterpret_cast<const unsigned char *>(&other);
+    std::memcpy(d, s, typesBegin);
+    std::memcpy(d + typesEnd, s + typesEnd, sizeof(Grid) - typesEnd);
+    std::memcpy(types, other.types, (std::size_t)other.height * sizeof(types[0]));
+}
+
+bool rectsOverlap(const Rect &a, const Rect &b) {
+    return (a.x < b.x + b.w &&
+            a.x + a.w > b.x &&
+            a.y < b.y + b.h &&
+            a.y + a.h > b.y);
+}
+
+// Board size as seen by the hot kernels. FixedBoard makes it a compile-time
+// constant for the common boards, so their loops have fixed trip counts and
+// their scratch masks are sized to the board; AnyBoard covers every other
+// size at runtime.
+template <int C, int R>
+struct FixedBoard {
+    static const int MAX_R = R;
+    int cols() const { return C; }
+    int rows() const { return R; }
+    RowMask full() const { return fullRowMask(C); }
+};
+
+struct AnyBoard {
+    static const int MAX_R = MAX_ROWS;
+    int c, r;
+    RowMask f;
+    int cols() const { return c; }
+    int rows() const { return r; }
+    RowMask full() const { return f; }
+};
+
+// Calls fn with the best board description for grid's size.
+template <class Fn>
+static void withBoard(const Grid &grid, Fn fn)
+{
+    if (grid.width == 16 && grid.height == 20) return fn(FixedBoard<16, 20>());
+    if (grid.width == 32 && grid.height == 20) return fn(FixedBoard<32, 20>());
+    fn(AnyBoard{ grid.width, grid.height, grid.full });
+}
+
+// Grows comp[] to everything 4-connected to it through allowed[].
+template <class B>
+static void floodFill(const B &b, RowMask comp[], const RowMask allowed[])
+{
+    const int rows = b.rows();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        // Alternate sweep directions so tall columns converge quickly.
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int k = 0; k < rows; ++k) {
+                int r = pass ? (rows - 1 - k) : k;
+                RowMask m = comp[r];
+                if (r > 0)        m |= comp[r - 1];
+                if (r < rows - 1) m |= comp[r + 1];
+                m &= allowed[r];
+                // Spread sideways along runs within the row
+                for (;;) {
+                    RowMask g = (m | (m << 1) | (m >> 1)) & allowed[r];
+                    if (g == m) break;
+                    m = g;
+                }
+                if (m != comp[r]) {
+                    comp[r] = m;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+template <class B>
+static void resolveClusters(const B &b, Grid &grid, ShapePool &shapes,
+                            float fallSpeed, int pLeftCol, int pRightCol,
+                            int pTopRow, int pBotRow)
+{
+    const int rows = b.rows(), cols = b.cols();
+
+    RowMask pending[B::MAX_R];
+    bool anyPending = false, anyFloating = false;
+    for (int r = 0; r < rows; ++r) {
+        pending[r] = grid.dirty[r] & grid.rows[r];
+        grid.dirty[r] = 0;
+        anyPending |= pending[r] != 0;
+    }
+    if (!anyPending) return;
+
+    // A tile directly below a cell is always in that cell's own cluster, so
+    // a cluster is held up only by the floor or by the player standing
+    // directly beneath one of its cells.
+    RowMask playerTop[B::MAX_R] = {};
+    for (int r = std::max(0, pTopRow - 1); r <= std::min(rows - 1, pBotRow - 1); ++r) {
+        int c0 = std::max(0, pLeftCol), c1 = std::min(cols - 1, pRightCol);
+        if (c0 <= c1) playerTop[r] = colRangeMask(c0, c1);
+    }
+    RowMask floating[B::MAX_R] = {};
+
+    // Classify each touched cluster once.
+    for (int r0 = 0; r0 < rows; ++r0) {
+        while (pending[r0]) {
+            RowMask comp[B::MAX_R] = {};
+            comp[r0] = pending[r0] & (0 - pending[r0]);
+            floodFill(b, comp, grid.rows);
+
+            bool supported = comp[rows - 1] != 0;
+            for (int r = 0; r < rows; ++r) {
+                supported |= (comp[r] & playerTop[r]) != 0;
+                pending[r] &= ~comp[r];
+            }
+            if (supported) continue;
+
+            for (int r = 0; r < rows; ++r) floating[r] |= comp[r];
+            anyFloating = true;
+        }
+    }
+    if (!anyFloating) return;
+
+    // Turn each floating cluster into one rigid falling shape, in row-major
+    // order of each cluster's first cell.
+    RowMask deferred[B::MAX_R] = {};
+    for (int r0 = 0; r0 < rows; ++r0) {
+        while (floating[r0]) {
+            RowMask comp[B::MAX_R] = {};
+            comp[r0] = floating[r0] & (0 - floating[r0]);
+            floodFill(b, comp, floating);
+
+            int minC = cols, minR = rows, cells = 0;
+            for (int r = 0; r < rows; ++r) {
+                floating[r] &= ~comp[r];
+                if (!comp[r]) continue;
+                if (r < minR) minR = r;
+                minC = std::min(minC, ctz64(comp[r]));
+                cells += popcount64(comp[r]);
+            }
+
+            if (!shapes.canFit(cells)) {
+                for (int r = 0; r < rows; ++r) deferred[r] |= comp[r];
+                continue;
+            }
+
+            FallingShape &fs = shapes.push((float)(minC * CELL),
+                                           (float)(minR * CELL),
+                                           fallSpeed);
+            for (int r = minR; r < rows; ++r) {
+                for (RowMask m = comp[r]; m; m &= m - 1) {
+                    int c = ctz64(m);
+                    shapes.addCell(fs, c - minC, r - minR, grid.typeAt(c, r));
+                    grid.erase(c, r);
+                }
+            }
+            shapes.findBottomCells(fs);
+        }
+    }
+
+    // The neighbours erase() flagged are empty or part of a lifted shape;
+    // only clusters the pool had no room for need another look.
+    for (int r = 0; r < rows; ++r) grid.dirty[r] = deferred[r];
+}
+
+void resolveFloatingClusters(Grid &grid,
+                             ShapePool &shapes,
+                             float fallSpeed,
+                             int pLeftCol,
+                             int pRightCol,
+                             int pTopRow,
+                             int pBotRow)
+{
+    withBoard(grid, [&](auto b) {
+        resolveClusters(b, grid, shapes, fallSpeed,
+                        pLeftCol, pRightCol, pTopRow, pBotRow);
+    });
+}
+
+void clampBoardSize(GameConfig &cfg)
+{
+    cfg.cols = std::min(std::max(cfg.cols, MIN_COLS), MAX_COLS);
+    cfg.rows = std::min(std::max(cfg.rows, MIN_ROWS), MAX_ROWS);
+}
+
+void copyGameState(GameState &dst, const GameState &src)
+{
+    // The board and the pool are nearly all of the struct and mostly
+    // unused; everything around them goes over in two flat copies.
+    const std::size_t gridBegin = offsetof(GameState, grid);
+    const std::size_t poolEnd   = offsetof(GameState, shapes) + sizeof(ShapePool);
+    unsigned char *d = reinterpret_cast<unsigned char *>(&dst);
+    const unsigned char *s = reinterpret_cast<const unsigned char *>(&src);
+    std::memcpy(d, s, gridBegin);
+    std::memcpy(d + poolEnd, s + poolEnd, sizeof(GameState) - poolEnd);
+    dst.grid.copyFrom(src.grid);
+    dst.shapes.copyFrom(src.shapes);
+}
+
+static void refillSpawnQueue(GameState &st);
+
+void resetGame(GameState &st, std::uint64_t seed)
+{
+    clampBoardSize(st.config);
+    st.grid.reset(st.config.cols, st.config.rows);
+
+    st.rng.seed(seed);
+    st.stats = GameStats{};
+
+    st.player.w = CELL;
+    st.player.h = CELL;
+    st.player.x = (st.grid.pixelWidth() - st.player.w) / 2;
+    st.player.y = st.grid.pixelHeight() - st.player.h - 10;
+    st.prevPlayerX = st.player.x;
+    st.prevPlayerY = st.player.y;
+    st.tick = 0;
+
+    st.playerVy  = 0.0f;
+    st.onGround  = false;
+    st.prevJump  = false;
+
+    st.shapes.clear();
+
+    st.spawnTimer           = 0.0f;
+    st.elapsedTime          = 0.0f;
+    st.cdLeft = st.cdRight = st.cdUp = st.cdDown = 0.0f;
+    st.timeSinceLastPowerup = 0.0f;
+    st.freezeTimer          = 0.0f;
+    st.gameOver             = false;
+
+    st.supportLeftCol = st.supportRightCol = -1;
+    st.supportTopRow  = st.supportBotRow   = -1;
+
+    st.garbagePending = 0;
+
+    st.rowsCheckedAt = st.clustersSettledAt = st.grid.generation;
+
+    st.spawnHead = st.spawnCount = 0;
+    if (!st.legacySpawns) refillSpawnQueue(st);
+}
+
+// Board cells a pixel rect can touch, clamped to the grid. Empty when the
+// rect is entirely off the board (r0 > r1 or c0 > c1).
+struct CellSpan {
+    int c0, c1, r0, r1;
+};
+
+static CellSpan cellsTouched(const Grid &grid, const Rect &r)
+{
+    CellSpan s;
+    s.c0 = std::max(0, r.x / CELL);
+    s.c1 = std::min(grid.width - 1, (r.x + r.w - 1) / CELL);
+    s.r0 = std::max(0, r.y / CELL);
+    s.r1 = std::min(grid.height - 1, (r.y + r.h - 1) / CELL);
+    return s;
+}
+
+// ===== Player movement =====
+// Collision only ever looks at the few cells around the player (at most
+// 2x3 for a one-cell player), never the whole stack.
+static void updatePlayer(GameState &st, InputMask input, float dt)
+{
+    const GameConfig &cfg = st.config;
+    const Grid &grid = st.grid;
+    Rect &player = st.player;
+
+    float oldPy = (float)player.y;
+
+    float vx = 0.0f;
+    if (input & INPUT_LEFT)  vx -= cfg.playerSpeed;
+    if (input & INPUT_RIGHT) vx += cfg.playerSpeed;
+
+    // Horizontal move
+    float newX = player.x + vx * dt;
+    if (newX < 0) newX = 0;
+    if (newX + player.w > grid.pixelWidth()) newX = (float)(grid.pixelWidth() - player.w);
+
+    Rect hTest = player;
+    hTest.x = (int)newX;
+    // Pushing the player out of one tile can shove it into the next, so the
+    // column span is re-derived whenever hTest moves. Rows stay put.
+    CellSpan hs = cellsTouched(grid, hTest);
+    for (int r = hs.r0; r <= hs.r1; ++r) {
+        for (int c = hs.c0; c <= hs.c1; ++c) {
+            if (!grid.occupied(c, r)) continue;
+            Rect br{ c * CELL, r * CELL, CELL, CELL };
+            if (rectsOverlap(hTest, br)) {
+                if (vx > 0) newX = br.x - player.w;
+                else if (vx < 0) newX = br.x + br.w;
+                hTest.x = (int)newX;
+                hs = cellsTouched(grid, hTest);
+            }
+        }
+    }
+    player.x = (int)newX;
+
+    // Jump only if grounded
+    bool jumpPressed = (input & INPUT_JUMP) != 0;
+    if (jumpPressed && !st.prevJump && st.onGround) {
+        st.playerVy = cfg.jumpV;
+        st.onGround = false;
+    }
+
+    // Gravity
+    st.playerVy += cfg.gravity * dt;
+    float newY = player.y + st.playerVy * dt;
+
+    // Reset & handle vertical collisions
+    st.onGround = false;
+
+    // Floor
+    if (newY + player.h >= grid.pixelHeight()) {
+        newY        = (float)(grid.pixelHeight() - player.h);
+        st.playerVy = 0.0f;
+        st.onGround = true;
+    }
+
+    Rect vTest = player;
+    vTest.y = (int)newY;
+
+    CellSpan vs = cellsTouched(grid, vTest);
+    for (int r = vs.r0; r <= vs.r1; ++r) {
+        for (int c = vs.c0; c <= vs.c1; ++c) {
+            if (!grid.occupied(c, r)) continue;
+            Rect br{ c * CELL, r * CELL, CELL, CELL };
+            if (!rectsOverlap(vTest, br)) continue;
+
+            // Landing on top of a block
+            if (st.playerVy > 0 && oldPy + player.h <= br.y) {
+                newY        = (float)(br.y - player.h);
+                st.playerVy = 0.0f;
+                st.onGround = true;
+                vTest.y     = (int)newY;
+            }
+            // Hitting head on block above
+            else if (st.playerVy < 0 && oldPy >= br.y + br.h) {
+                newY        = (float)(br.y + br.h);
+                st.playerVy = 0.0f;
+                vTest.y     = (int)newY;
+            }
+        }
+    }
+
+    player.y = (int)newY;
+
+    // EXTRA: robust onGround check so jumps don't get "stolen"
+    st.onGround = false;
+    int footY = player.y + player.h;
+    if (footY >= grid.pixelHeight() - 1) {
+        st.onGround = true;
+    } else if (footY >= 0 && footY % CELL == 0) {
+        // Standing on a tile top: any occupied cell under the player's columns.
+        CellSpan ps = cellsTouched(grid, player);
+        RowMask under = colRangeMask(ps.c0, ps.c1);
+        st.onGround = (grid.rows[footY / CELL] & under) != 0;
+    }
+}
+
+// ===== Spawn falling shapes =====
+static const std::uint8_t SHAPE_W[5] = { 1, 2, 4, 1, 1 };
+static const std::uint8_t SHAPE_H[5] = { 1, 1, 1, 2, 4 };
+
+static void refillSpawnQueue(GameState &st)
+{
+    for (; st.spawnCount < SPAWN_QUEUE; ++st.spawnCount) {
+        SpawnSpec &s = st.spawnQueue[(st.spawnHead + st.spawnCount) % SPAWN_QUEUE];
+        int shape = st.rng.below(5);
+        s.w = SHAPE_W[shape];
+        s.h = SHAPE_H[shape];
+        int maxCol = st.grid.width - s.w;
+        s.col       = (std::uint8_t)(maxCol > 0 ? st.rng.below(maxCol + 1) : 0);
+        s.powerRoll = (std::uint8_t)st.rng.below(100);
+        s.powerCell = (std::uint8_t)st.rng.below(s.w * s.h);
+        s.powerType = (std::uint8_t)(BOMB + st.rng.below(4));
+    }
+}
+
+// Every cell NORMAL; null when the pool is full and the spawn is skipped.
+static FallingShape *pushShape(GameState &st, int wCells, int hCells, int col, float fallSpeed)
+{
+    if (!st.shapes.canFit(wCells * hCells)) return nullptr;
+    FallingShape &fs = st.shapes.push((float)(col * CELL),
+                                      (float)(-hCells * CELL),
+                                      fallSpeed);
+    for (int dy = 0; dy < hCells; ++dy)
+        for (int dx = 0; dx < wCells; ++dx)
+            st.shapes.addCell(fs, dx, dy, NORMAL);
+    return &fs;
+}
+
+static void makePowerup(GameState &st, FallingShape &fs, int cell, BlockType type)
+{
+    ShapeCell &c = st.shapes.cells[fs.first + cell];
+    c = packCell(cellDx(c), cellDy(c), type);
+    st.timeSinceLastPowerup = 0.0f;
+}
+
+// The spawn sequence from before the queue, draw for draw.
+static void spawnLegacyShape(GameState &st, float fallSpeed)
+{
+    const GameConfig &cfg = st.config;
+
+    int shape = st.rng.below(5);
+    int wCells = SHAPE_W[shape], hCells = SHAPE_H[shape];
+
+    int maxCol = st.grid.width - wCells;
+    int col = (maxCol > 0) ? st.rng.below(maxCol + 1) : 0;
+
+    int total = wCells * hCells;
+    FallingShape *fs = pushShape(st, wCells, hCells, col, fallSpeed);
+    if (!fs) return;
+
+    // Powerup spawn logic
+    bool makePower = false;
+    int powerIndex = -1;
+    if (st.timeSinceLastPowerup >= cfg.powerupMaxGap) {
+        makePower = true;
+        powerIndex = st.rng.below(total);
+    } else if (st.rng.below(100) < 7) { // ~7% chance
+        makePower = true;
+        powerIndex = st.rng.below(total);
+    }
+    if (makePower) makePowerup(st, *fs, powerIndex, (BlockType)(BOMB + st.rng.below(4)));
+
+    st.shapes.findBottomCells(*fs);
+}
+
+static void spawnShapes(GameState &st, float fallSpeed, float dt)
+{
+    const GameConfig &cfg = st.config;
+
+    st.spawnTimer += dt;
+    if (st.spawnTimer < cfg.spawnInterval) return;
+    st.spawnTimer = 0.0f;
+
+    if (st.legacySpawns) {
+        spawnLegacyShape(st, fallSpeed);
+        return;
+    }
+
+    SpawnSpec spec = st.spawnQueue[st.spawnHead];
+    st.spawnHead = (std::uint8_t)((st.spawnHead + 1) % SPAWN_QUEUE);
+    if (--st.spawnCount == 0) refillSpawnQueue(st);
+
+    FallingShape *fs = pushShape(st, spec.w, spec.h, spec.col, fallSpeed);
+    if (!fs) return;   // pool full: skip this spawn
+    // The gap guarantee, or the ~7% chance.
+    if (st.timeSinceLastPowerup >= cfg.powerupMaxGap || spec.powerRoll < 7)
+        makePowerup(st, *fs, spec.powerCell, (BlockType)spec.powerType);
+    st.shapes.findBottomCells(*fs);
+}
+
+// ===== Update falling shapes =====
+template <class B>
+static void updateFalling(const B &b, GameState &st, float dt)
+{
+    Grid &grid = st.grid;
+    ShapePool &pool = st.shapes;
+    const int floorY = b.rows() * CELL;
+    bool anyLanded = false;
+
+    for (int k = 0; k < pool.shapeCount; ++k) {
+        FallingShape &s = pool.shapes[k];
+        float newY   = s.y + s.speed * dt;
+        float finalY = newY;
+        bool landed  = false;
+
+        // Only cells with nothing of their own shape beneath can touch down.
+        for (int i = s.first; i < s.first + s.bottomCount; ++i) {
+            int cx = cellDx(pool.cells[i]), cy = cellDy(pool.cells[i]);
+
+            float oldBottom = s.y + (cy + 1) * CELL;
+            float newBottom = newY + (cy + 1) * CELL;
+
+            // Ground
+            if (newBottom >= floorY) {
+                float candY = (float)(floorY - (cy + 1) * CELL);
+                if (!landed || candY < finalY) {
+                    finalY = candY;
+                    landed = true;
+                }
+            }
+
+            // Static below
+            int c = (int)((s.x + cx * CELL) / CELL);
+            if (c < 0 || c >= b.cols()) continue;
+
+            // First tile whose top is at or below the old bottom edge; the
+            // nudges keep the float comparison identical to a row scan.
+            int r = std::max(0, (int)std::ceil(oldBottom / CELL));
+            if (r > 0 && (float)((r - 1) * CELL) >= oldBottom) --r;
+            if ((float)(r * CELL) < oldBottom) ++r;
+            r = grid.firstOccupiedFrom(c, r);
+            if (r < b.rows()) {
+                float tileTop = (float)(r * CELL);
+                if (newBottom >= tileTop) {
+                    float candY = tileTop - (cy + 1) * CELL;
+                    if (!landed || candY < finalY) {
+                        finalY = candY;
+                        landed = true;
+                    }
+                }
+            }
+        }
+
+        if (landed) {
+            s.y = finalY;
+            // convert to static
+            for (int i = s.first; i < s.first + s.count; ++i) {
+                ShapeCell cell = pool.cells[i];
+                int col = (int)((s.x / CELL) + cellDx(cell));
+                int row = (int)((s.y / CELL) + cellDy(cell));
+                if (col >= 0 && col < b.cols() && row >= 0 && row < b.rows())
+                    grid.set(col, row, cellType(cell));
+            }
+            s.count = 0;
+            anyLanded = true;
+        } else {
+            s.y = newY;
+        }
+    }
+
+    if (anyLanded) pool.compact();
+}
+
+void updateFallingShapes(GameState &st, float dt)
+{
+    withBoard(st.grid, [&](auto b) { updateFalling(b, st, dt); });
+}
+
+// Remove every falling cell over the cell rectangle, compacting each shape
+// in place and dropping the ones left empty. The rectangle need not lie on
+// the board; shapes whose extent misses it are skipped without a look at
+// their cells.
+static void eraseFallingCells(ShapePool &pool, const CellSpan &area)
+{
+    bool changed = false;
+    for (int k = 0; k < pool.shapeCount; ++k) {
+        FallingShape &s = pool.shapes[k];
+        int gc0 = (int)(s.x / CELL);
+        int gr0 = (int)(s.y / CELL);
+        if (gc0 > area.c1 || gc0 + s.w - 1 < area.c0 ||
+            gr0 > area.r1 || gr0 + s.h - 1 < area.r0) continue;
+        int end = s.first + s.count;
+        int w = s.first;
+        for (int i = s.first; i < end; ++i) {
+            int gc = gc0 + cellDx(pool.cells[i]), gr = gr0 + cellDy(pool.cells[i]);
+            if (gc >= area.c0 && gc <= area.c1 && gr >= area.r0 && gr <= area.r1) continue;
+            pool.cells[w++] = pool.cells[i];
+        }
+        if (w == end) continue;
+        s.count = (std::uint16_t)(w - s.first);
+        pool.findBottomCells(s);
+        changed = true;
+    }
+    if (changed) pool.compact();
+}
+
+void applyPower(GameState &st, BlockType type, int col, int row)
+{
+    Grid &grid = st.grid;
+
+    if (type == NORMAL) return;
+    st.stats.powerupsUsed++;
+
+    if (type == BOMB) {
+        int rad = 5;
+        int r0 = std::max(0, row - rad), r1 = std::min(grid.height - 1, row + rad);
+        int c0 = std::max(0, col - rad), c1 = std::min(grid.width - 1, col + rad);
+        grid.eraseRect(c0, c1, r0, r1);
+        eraseFallingCells(st.shapes, CellSpan{ col - rad, col + rad, row - rad, row + rad });
+    }
+
+    if (type == FREEZE) {
+        // Freeze everything in place: no falling, no new clusters until it ends
+        st.freezeTimer = st.config.freezeDuration;
+    }
+
+    // Shapes can hang above the board, so the beams reach past its edges.
+    if (type == LASER_H) {
+        grid.clearRow(row);
+        eraseFallingCells(st.shapes, CellSpan{ INT_MIN, INT_MAX, row, row });
+    }
+
+    if (type == LASER_V) {
+        grid.eraseRect(col, col, 0, grid.height - 1);
+        eraseFallingCells(st.shapes, CellSpan{ col, col, INT_MIN, INT_MAX });
+    }
+}
+
+// Break the tile at (tc, tr) if the cooldown allows. A direct grid lookup
+// and erase(), which flags the 3x3 around it for the next cluster pass, so
+// holding all four arrows costs four bit operations, not stack searches.
+static bool breakAt(GameState &st, int tc, int tr, float &cd, BlockType &usedType)
+{
+    if (cd > 0.0f) return false;
+    if (tc < 0 || tc >= st.grid.width || tr < 0 || tr >= st.grid.height) return false;
+    if (!st.grid.occupied(tc, tr)) return false;
+    usedType = st.grid.typeAt(tc, tr);
+    st.grid.erase(tc, tr);
+    cd = st.config.abilityCd;
+    return true;
+}
+
+// ===== Directional abilities: arrow keys with cooldowns =====
+static void useAbilities(GameState &st, InputMask input)
+{
+    int pCol = st.player.x / CELL;
+    int pRow = st.player.y / CELL;
+
+    BlockType usedType = NORMAL;
+
+    if (input & INPUT_BREAK_LEFT) {
+        int tc = pCol - 1, tr = pRow;
+        if (breakAt(st, tc, tr, st.cdLeft, usedType)) applyPower(st, usedType, tc, tr);
+    }
+    if (input & INPUT_BREAK_RIGHT) {
+        int tc = pCol + 1, tr = pRow;
+        if (breakAt(st, tc, tr, st.cdRight, usedType)) applyPower(st, usedType, tc, tr);
+    }
+    if (input & INPUT_BREAK_UP) {
+        int tc = pCol, tr = pRow - 1;
+        if (breakAt(st, tc, tr, st.cdUp, usedType)) applyPower(st, usedType, tc, tr);
+    }
+    if (input & INPUT_BREAK_DOWN) {
+        int tc = pCol, tr = pRow + 1;
+        if (breakAt(st, tc, tr, st.cdDown, usedType)) applyPower(st, usedType, tc, tr);
+    }
+}
+
+// ===== Versus garbage =====
+void addGarbage(GameState &st, int rows, int hole)
+{
+    for (; rows > 0 && st.garbagePending < MAX_ROWS; --rows)
+        st.garbageHole[st.garbagePending++] = (std::uint8_t)hole;
+}
+
+// Raise the board by the pending rows. Returns true if that pushed tiles
+// off the top.
+static bool riseGarbage(GameState &st)
+{
+    Grid &grid = st.grid;
+    const int n = std::min(st.garbagePending, grid.height);
+    st.garbagePending = 0;
+
+    bool toppedOut = false;
+    for (int r = 0; r < n; ++r) {
+        toppedOut = toppedOut || grid.rows[r];
+        grid.count -= popcount64(grid.rows[r]);
+    }
+
+    int keep = grid.height - n;
+    std::memmove(grid.rows, grid.rows + n, (std::size_t)keep * sizeof(RowMask));
+    std::memmove(grid.types[0], grid.types[n], (std::size_t)keep * MAX_COLS);
+    for (int i = 0; i < n; ++i) {
+        int r = keep + i;
+        int hole = std::min((int)st.garbageHole[i], grid.width - 1);
+        grid.rows[r] = grid.full & ~((RowMask)1u << hole);
+        std::memset(grid.types[r], NORMAL, (std::size_t)grid.width);
+        grid.count += grid.width - 1;
+    }
+    grid.rebuildCols();
+    grid.markAllDirty();
+
+    // Everything above the stack keeps its place relative to it.
+    const int lift = n * CELL;
+    for (int k = 0; k < st.shapes.shapeCount; ++k) {
+        st.shapes.shapes[k].y     -= (float)lift;
+        st.shapes.shapes[k].prevY -= (float)lift;
+    }
+    st.player.y    = std::max(0, st.player.y - lift);
+    st.prevPlayerY = std::max(0, st.prevPlayerY - lift);
+
+    if (toppedOut) st.gameOver = true;
+    return toppedOut;
+}
+
+// ===== Full row clear =====
+// Bit r set => row r is full. Rows past the board are empty, so comparing
+// them too is harmless; with SSE2 two rows go per compare.
+template <class B>
+static std::uint64_t fullRows(const B &b, const Grid &grid)
+{
+    std::uint64_t bits = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i full = _mm_set1_epi64x((long long)b.full());
+    for (int r = 0; r < b.rows(); r += 2) {
+        __m128i v  = _mm_loadu_si128((const __m128i *)(grid.rows + r));
+        __m128i eq = _mm_cmpeq_epi32(v, full);
+        // A 64-bit lane matches only if both of its halves do.
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        bits |= (std::uint64_t)_mm_movemask_pd(_mm_castsi128_pd(eq)) << r;
+    }
+#else
+    for (int r = 0; r < b.rows(); ++r)
+        bits |= (std::uint64_t)(grid.rows[r] == b.full()) << r;
+#endif
+    return bits;
+}
+
+template <class B>
+static int clearRows(const B &b, Grid &grid)
+{
+    std::uint64_t full = fullRows(b, grid);
+    if (!full) return 0;
+    int cleared = popcount64(full);
+
+    // Bottom-up, slide each run of surviving rows down over the full rows
+    // below it: one move per run rather than per row.
+    int dst = b.rows(), top = b.rows();
+    for (std::uint64_t f = full; ; ) {
+        int h = f ? msb64(f) : -1;
+        int n = top - 1 - h;
+        dst -= n;
+        if (n && dst != h + 1) {
+            std::memmove(grid.rows + dst, grid.rows + h + 1, (std::size_t)n * sizeof(RowMask));
+            std::memmove(grid.types[dst], grid.types[h + 1], (std::size_t)n * MAX_COLS);
+        }
+        if (h < 0) break;
+        top = h;
+        f &= ~((std::uint64_t)1u << h);
+    }
+    for (int r = 0; r < dst; ++r) grid.rows[r] = 0;
+    grid.count -= cleared * b.cols();
+
+    // Same removal in each column mask: drop the row's bit and shift the
+    // rows above down one. Ascending order keeps later indices valid.
+    for (std::uint64_t f = full; f; f &= f - 1) {
+        int h = ctz64(f);
+        ColMask above = ((ColMask)1u << h) - 1;
+        for (int c = 0; c < b.cols(); ++c) {
+            ColMask m = grid.cols[c];
+            grid.cols[c] = (m & ~(above | ((ColMask)1u << h))) | ((m & above) << 1);
+        }
+    }
+    grid.markAllDirty();
+    return cleared;
+}
+
+int clearFullRows(Grid &grid)
+{
+    int cleared = 0;
+    withBoard(grid, [&](auto b) { cleared = clearRows(b, grid); });
+    return cleared;
+}
+
+bool step(GameState &st, InputMask input, float dt, Profiler *prof)
+{
+    const GameConfig &cfg = st.config;
+
+    // Remember where everything was, for render interpolation.
+    ++st.tick;
+    st.prevPlayerX = st.player.x;
+    st.prevPlayerY = st.player.y;
+    for (int k = 0; k < st.shapes.shapeCount; ++k)
+        st.shapes.shapes[k].prevY = st.shapes.shapes[k].y;
+
+    if (!st.gameOver) {
+        st.elapsedTime += dt;
+        st.timeSinceLastPowerup += dt;
+    }
+
+    if (st.freezeTimer > 0.0f) {
+        st.freezeTimer -= dt;
+        if (st.freezeTimer < 0.0f) st.freezeTimer = 0.0f;
+    }
+
+    float fallSpeed = cfg.baseFall + std::min(cfg.maxExtra, st.elapsedTime * 5.0f);
+
+    // Cooldowns
+    st.cdLeft  = std::max(0.0f, st.cdLeft  - dt);
+    st.cdRight = std::max(0.0f, st.cdRight - dt);
+    st.cdUp    = std::max(0.0f, st.cdUp    - dt);
+    st.cdDown  = std::max(0.0f, st.cdDown  - dt);
+
+    if (st.gameOver) {
+        st.prevJump = (input & INPUT_JUMP) != 0;
+        return false;
+    }
+
+    if (st.garbagePending > 0 && riseGarbage(st)) return true;
+
+    {
+        ProfileScope scope(prof, PHASE_PLAYER);
+        updatePlayer(st, input, dt);
+        st.prevJump = (input & INPUT_JUMP) != 0;
+    }
+    {
+        ProfileScope scope(prof, PHASE_SPAWN);
+        spawnShapes(st, fallSpeed, dt);
+    }
+    // Respect freeze
+    if (st.freezeTimer <= 0.0f) {
+        ProfileScope scope(prof, PHASE_FALLING);
+        updateFallingShapes(st, dt);
+    }
+    {
+        ProfileScope scope(prof, PHASE_ABILITIES);
+        useAbilities(st, input);
+    }
+    // A full row can only appear when tiles change; a quiet frame skips
+    // the scan.
+    if (st.grid.count > 0 && st.grid.generation != st.rowsCheckedAt) {
+        ProfileScope scope(prof, PHASE_ROW_CLEAR);
+        st.stats.rowsCleared += clearFullRows(st.grid);
+        st.rowsCheckedAt = st.grid.generation;
+    }
+
+    // ===== Floating clusters -> falling shapes
+    // IMPORTANT: do NOT create falling shapes while frozen,
+    // or freeze becomes useless (they'd turn red/unbreakable).
+    if (st.freezeTimer <= 0.0f) {
+        ProfileScope scope(prof, PHASE_CLUSTERS);
+        const Rect &player = st.player;
+        int pLeftCol  = player.x / CELL;
+        int pRightCol = (player.x + player.w - 1) / CELL;
+        int pTopRow   = player.y / CELL;
+        int pBotRow   = (player.y + player.h - 1) / CELL;
+
+        if (pLeftCol != st.supportLeftCol || pRightCol != st.supportRightCol ||
+            pTopRow != st.supportTopRow || pBotRow != st.supportBotRow) {
+            st.grid.markDirty(st.supportLeftCol, st.supportRightCol,
+                              st.supportTopRow - 1, st.supportBotRow - 1);
+            st.supportLeftCol  = pLeftCol;
+            st.supportRightCol = pRightCol;
+            st.supportTopRow   = pTopRow;
+            st.supportBotRow   = pBotRow;
+        }
+
+        // Nothing landed, broke, cleared or lost its support since the
+        // last pass settled everything: the dirty set is empty too.
+        if (st.grid.generation != st.clustersSettledAt) {
+            resolveFloatingClusters(st.grid, st.shapes,
+                                    fallSpeed,
+                                    pLeftCol, pRightCol,
+                                    pTopRow, pBotRow);
+            // Clusters the pool had no room for stay dirty for next time.
+            if (!st.grid.anyDirty()) st.clustersSettledAt = st.grid.generation;
+        }
+    }
+
+    // ===== Game Over check =====
+    ProfileScope scope(prof, PHASE_GAME_OVER);
+    if (st.grid.rows[0] != 0) {
+        st.gameOver = true;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,451 @@
+#pragma once
+
+// Simulation core for Block Till You Drop. Everything in here is plain C++
+// with no SDL dependency, so the same update step drives the windowed game
+// and the headless runner.
+
+#include <cstdint>
+#include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "rng.h"
+
+class Profiler;
+
+static const int CELL = 30;       // pixels per board cell
+
+// The board size is a runtime option (GameConfig::cols/rows) up to
+// MAX_COLS x MAX_ROWS, so a row or a column always fits one 64-bit mask.
+static const int DEFAULT_COLS = 16;
+static const int DEFAULT_ROWS = 20;
+static const int MIN_COLS     = 4;     // widest spawned shape
+static const int MIN_ROWS     = 4;     // tallest spawned shape
+static const int MAX_COLS     = 64;
+static const int MAX_ROWS     = 64;
+
+// The simulation advances in fixed ticks. Frontends accumulate real time,
+// run whole ticks, and interpolate between the last two for display.
+static const int   TICK_RATE = 120;
+static const float TICK_DT   = 1.0f / TICK_RATE;
+
+enum BlockType {
+    NORMAL = 0,
+    BOMB,
+    FREEZE,
+    LASER_H,
+    LASER_V
+};
+
+// Same layout as SDL_Rect / SDL_Point so the frontend can hand them
+// straight to the renderer.
+struct Rect {
+    int x, y, w, h;
+};
+
+struct Point {
+    int x, y;
+};
+
+
+// Occupancy bitboard for the static stack: one bit per column in each row
+// mask plus a row-major type plane. It is the single source of truth for
+// landed tiles and is updated in place on land/break/clear. A transposed
+// copy (one bit per row in each column mask) answers "first tile below"
+// queries with a single count-trailing-zeros. Mutations also flag the cells
+// whose cluster may have changed, so resolveFloatingClusters() only has to
+// look at those. Every change to the tiles or the dirty set also bumps
+// `generation`, so a pass that saw the grid at one generation can be
+// skipped until it moves on. Storage is sized for the largest board; only
+// the first `height` rows and `width` columns are used.
+typedef std::uint64_t RowMask;
+typedef std::uint64_t ColMask;
+static_assert(MAX_COLS <= 64, "RowMask needs one bit per column");
+static_assert(MAX_ROWS <= 64, "ColMask needs one bit per row");
+
+inline int ctz64(std::uint64_t m) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward64(&i, m);
+    return (int)i;
+#else
+    return __builtin_ctzll(m);
+#endif
+}
+
+// Index of the highest set bit; m must be nonzero.
+inline int msb64(std::uint64_t m) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanReverse64(&i, m);
+    return (int)i;
+#else
+    return 63 - __builtin_clzll(m);
+#endif
+}
+
+// Kernighan's loop: rows are sparse enough that it beats a portable
+// popcount, which without -mpopcnt is a library call.
+inline int popcount64(std::uint64_t m) {
+    int n = 0;
+    for (; m; m &= m - 1) ++n;
+    return n;
+}
+
+// Bits 0..width-1 (1 <= width <= 64).
+constexpr RowMask fullRowMask(int width) {
+    return ~(RowMask)0 >> (64 - width);
+}
+
+// Bits c0..c1 inclusive (0 <= c0 <= c1 < 64).
+inline RowMask colRangeMask(int c0, int c1) {
+    return (~(RowMask)0 >> (63 - (c1 - c0))) << c0;
+}
+
+struct Grid {
+    int          width, height;                 // board size in cells
+    RowMask      full;                          // a complete row
+    RowMask      rows[MAX_ROWS];                // bit c set => (c, r) occupied
+    ColMask      cols[MAX_COLS];                // bit r set => (c, r) occupied
+    RowMask      dirty[MAX_ROWS];               // cells to re-check for support
+    std::uint8_t types[MAX_ROWS][MAX_COLS];     // BlockType, valid where the bit is set
+    int          count;                         // number of occupied cells
+    std::uint32_t generation;                   // bumped on every change
+
+    // Same as assignment, but type rows past the board's height are left
+    // alone: no mask bit can point into them.
+    void copyFrom(const Grid &other);
+
+    // Empty board of w x h cells; the caller keeps the size within limits.
+    void reset(int w, int h) {
+        width  = w;
+        height = h;
+        full   = fullRowMask(w);
+        generation = 0;
+        clear();
+    }
+
+    void clear() {
+        for (int r = 0; r < MAX_ROWS; ++r) rows[r] = dirty[r] = 0;
+        for (int c = 0; c < MAX_COLS; ++c) cols[c] = 0;
+        count = 0;
+        ++generation;
+    }
+
+    int pixelWidth() const  { return width * CELL; }
+    int pixelHeight() const { return height * CELL; }
+
+    bool occupied(int c, int r) const { return (rows[r] >> c) & 1u; }
+    BlockType typeAt(int c, int r) const { return (BlockType)types[r][c]; }
+    bool rowFull(int r) const { return rows[r] == full; }
+
+    bool anyDirty() const {
+        RowMask any = 0;
+        for (int r = 0; r < height; ++r) any |= dirty[r];
+        return any != 0;
+    }
+
+    // Topmost occupied row >= r in column c, or height if there is none.
+    int firstOccupiedFrom(int c, int r) const {
+        if (r >= height) return height;
+        ColMask m = cols[c] >> r;
+        return m ? r + ctz64(m) : height;
+    }
+
+    void set(int c, int r, BlockType t) {
+        if (!occupied(c, r)) {
+            rows[r] |= (RowMask)1u << c;
+            cols[c] |= (ColMask)1u << r;
+            ++count;
+        }
+        types[r][c] = (std::uint8_t)t;
+        dirty[r] |= (RowMask)1u << c;
+        ++generation;
+    }
+
+    void erase(int c, int r) {
+        if (occupied(c, r)) {
+            rows[r] &= ~((RowMask)1u << c);
+            cols[c] &= ~((ColMask)1u << r);
+            --count;
+            markDirty(c - 1, c + 1, r - 1, r + 1);
+        }
+    }
+
+    // Erase every tile in the cell rectangle (within the board) with one
+    // AND-NOT per row and column mask. Only cells next to a removed tile
+    // are marked dirty, as erase() would.
+    void eraseRect(int c0, int c1, int r0, int r1) {
+        RowMask rm = colRangeMask(c0, c1);
+        RowMask hit[MAX_ROWS + 2] = {};           // hit[r + 1]: removed in row r
+        bool any = false;
+        for (int r = r0; r <= r1; ++r) {
+            RowMask e = rows[r] & rm;
+            if (!e) continue;
+            rows[r] &= ~rm;
+            count -= popcount64(e);
+            hit[r + 1] = (e | (e << 1) | (e >> 1)) & full;
+            any = true;
+        }
+        if (!any) return;
+        ++generation;
+        ColMask cm = colRangeMask(r0, r1);
+        for (int c = c0; c <= c1; ++c) cols[c] &= ~cm;
+        int d0 = r0 > 0 ? r0 - 1 : 0;
+        int d1 = r1 < height - 1 ? r1 + 1 : height - 1;
+        for (int r = d0; r <= d1; ++r) dirty[r] |= hit[r] | hit[r + 1] | hit[r + 2];
+    }
+
+    void clearRow(int r) {
+        count -= popcount64(rows[r]);
+        rows[r] = 0;
+        for (int c = 0; c < width; ++c) cols[c] &= ~((ColMask)1u << r);
+        markDirty(0, width - 1, r - 1, r + 1);
+    }
+
+    // Flag a cell rectangle (clamped to the board) for the next cluster pass.
+    void markDirty(int c0, int c1, int r0, int r1) {
+        c0 = c0 < 0 ? 0 : c0;
+        c1 = c1 >= width ? width - 1 : c1;
+        r0 = r0 < 0 ? 0 : r0;
+        r1 = r1 >= height ? height - 1 : r1;
+        if (c0 > c1) return;
+        RowMask m = colRangeMask(c0, c1);
+        for (int r = r0; r <= r1; ++r) dirty[r] |= m;
+        ++generation;
+    }
+
+    // Also the way to announce rows rewritten in bulk.
+    void markAllDirty() {
+        for (int r = 0; r < height; ++r) dirty[r] = full;
+        ++generation;
+    }
+
+    // Re-derive the column masks after rows were rewritten wholesale.
+    void rebuildCols() {
+        for (int c = 0; c < width; ++c) cols[c] = 0;
+        for (int r = 0; r < height; ++r)
+            for (RowMask m = rows[r]; m; m &= m - 1)
+                cols[ctz64(m)] |= (ColMask)1u << r;
+    }
+};
+
+// Falling shapes live in a fixed-capacity pool so the steady-state frame
+// never touches the heap. Each cell is one 16-bit word; each shape owns the
+// index range [first, first + count), kept in ascending order of first, and
+// lists its bottom-facing cells (nothing of the same shape directly below)
+// at the front of that range.
+static const int MAX_SHAPES      = 128;
+static const int MAX_SHAPE_CELLS = 2 * MAX_ROWS * MAX_COLS;
+
+// Cell word: dx in bits 0-5, dy in bits 6-11 (CELL units from the shape's
+// top-left), BlockType in bits 12-15. A cluster can be as large as the
+// board, so an offset needs all six bits.
+typedef std::uint16_t ShapeCell;
+
+inline ShapeCell packCell(int dx, int dy, BlockType t) {
+    return (ShapeCell)(dx | (dy << 6) | ((int)t << 12));
+}
+inline int       cellDx(ShapeCell c)   { return c & 63; }
+inline int       cellDy(ShapeCell c)   { return (c >> 6) & 63; }
+inline BlockType cellType(ShapeCell c) { return (BlockType)(c >> 12); }
+
+static_assert(MAX_COLS <= 64 && MAX_ROWS <= 64, "ShapeCell offsets are six bits");
+
+struct FallingShape {
+    float x, y;                   // top-left in pixels
+    float prevY;                  // y at the start of the current tick
+    float speed;                  // px/s
+    std::uint16_t first;          // first cell in the pool
+    std::uint16_t count;          // number of cells
+    std::uint16_t bottomCount;    // cells [first, first + bottomCount) face down
+    std::uint8_t  w, h;           // cell extent; may overstate after erasures
+};
+
+struct ShapePool {
+    FallingShape  shapes[MAX_SHAPES];
+    ShapeCell     cells[MAX_SHAPE_CELLS];
+    int shapeCount;
+    int cellCount;
+
+    void clear() { shapeCount = cellCount = 0; }
+
+    // Same as assignment, but only the shapes and cells in use are copied.
+    void copyFrom(const ShapePool &other);
+
+    bool canFit(int cells) const {
+        return shapeCount < MAX_SHAPES && cellCount + cells <= MAX_SHAPE_CELLS;
+    }
+
+    // Open a new, empty shape at the end of the pool. Check canFit() first.
+    FallingShape &push(float x, float y, float speed) {
+        FallingShape &s = shapes[shapeCount++];
+        s.x = x;
+        s.y = s.prevY = y;
+        s.speed = speed;
+        s.first = (std::uint16_t)cellCount;
+        s.count = s.bottomCount = 0;
+        s.w = s.h = 0;
+        return s;
+    }
+
+    // Append a cell to the most recently pushed shape.
+    void addCell(FallingShape &s, int cx, int cy, BlockType t) {
+        cells[cellCount++] = packCell(cx, cy, t);
+        ++s.count;
+        if (cx >= s.w) s.w = (std::uint8_t)(cx + 1);
+        if (cy >= s.h) s.h = (std::uint8_t)(cy + 1);
+    }
+
+    // Re-sort s's bottom-facing cells to the front; call after its cells change.
+    void findBottomCells(FallingShape &s);
+
+    // Drop shapes with no cells left and close the gaps between ranges.
+    void compact();
+};
+
+// One bit per logical button; the frontend maps keys onto these.
+enum InputBits {
+    INPUT_LEFT        = 1 << 0,  // A
+    INPUT_RIGHT       = 1 << 1,  // D
+    INPUT_JUMP        = 1 << 2,  // Space
+    INPUT_BREAK_LEFT  = 1 << 3,  // Arrow keys
+    INPUT_BREAK_RIGHT = 1 << 4,
+    INPUT_BREAK_UP    = 1 << 5,
+    INPUT_BREAK_DOWN  = 1 << 6
+};
+typedef std::uint8_t InputMask;
+
+// Tunables
+struct GameConfig {
+    int   cols            = DEFAULT_COLS;  // board size in cells
+    int   rows            = DEFAULT_ROWS;
+
+    float playerSpeed     = 220.0f;
+    float gravity         = 900.0f;
+    float jumpV           = -430.0f;
+    float abilityCd       = 0.5f;   // cooldown per direction
+
+    float spawnInterval   = 0.75f;
+    float baseFall        = 220.0f;
+    float maxExtra        = 60.0f;  // gentle speed-up
+    float powerupMaxGap   = 15.0f;  // guarantee one powerup in this window
+    float freezeDuration  = 10.0f;
+};
+
+// Upcoming spawns, drawn from the game's Rng SPAWN_QUEUE at a time whenever
+// the queue runs dry. A spawn just pops a ready spec, and the next one is
+// always known, for the preview. Whether the powerup roll is used is only
+// decided at spawn time, since the powerup gap guarantee depends on it.
+static const int SPAWN_QUEUE = 16;
+
+struct SpawnSpec {
+    std::uint8_t w, h;           // cells, one of the five shape templates
+    std::uint8_t col;            // leftmost column
+    std::uint8_t powerRoll;      // 0..99; below 7 makes a powerup regardless
+    std::uint8_t powerCell;      // which cell would be the powerup
+    std::uint8_t powerType;      // BlockType it would be
+};
+
+// Per-game counters for balance runs.
+struct GameStats {
+    int rowsCleared;
+    int powerupsUsed;
+};
+
+struct GameState {
+    GameConfig config;
+    Rng        rng;
+    GameStats  stats;
+
+    std::uint32_t tick;        // completed steps since reset
+
+    Rect  player;
+    int   prevPlayerX, prevPlayerY;  // player position before the last step
+    float playerVy;
+    bool  onGround;
+    bool  prevJump;
+
+    Grid grid;
+    ShapePool shapes;
+
+    float spawnTimer;
+    float elapsedTime;
+    float cdLeft, cdRight, cdUp, cdDown;
+    float timeSinceLastPowerup;
+    float freezeTimer;
+    bool  gameOver;
+
+    SpawnSpec    spawnQueue[SPAWN_QUEUE];    // ring; spawnHead is next
+    std::uint8_t spawnHead, spawnCount;      // count >= 1 after reset
+    // Replays recorded before the queue drew each spawn straight from the
+    // Rng as it happened; they set this (resetGame keeps it) to match.
+    // The queue stays empty then.
+    bool         legacySpawns = false;
+
+    // Player cells used by the last cluster pass. Clusters resting on the
+    // player need a re-check once it moves off them.
+    int supportLeftCol, supportRightCol, supportTopRow, supportBotRow;
+
+    // grid.generation as the row-clear and cluster passes last left it:
+    // while it has not moved on, there is nothing for them to find.
+    std::uint32_t rowsCheckedAt, clustersSettledAt;
+
+    // Versus garbage waiting to rise at the next step, oldest first: the
+    // hole column of each row.
+    int          garbagePending;
+    std::uint8_t garbageHole[MAX_ROWS];
+};
+
+// Everything step() touches lives in GameState by value, so a state can be
+// saved and restored with plain copies for rollback and replay seeking.
+static_assert(std::is_trivially_copyable<GameState>::value,
+              "GameState must stay a flat copyable block");
+
+// dst = src, copying only the live rows of the board and the live part of
+// the shape pool: under 3 KB on the default board plus two bytes per
+// falling cell, against ~25 KB for the full struct.
+void copyGameState(GameState &dst, const GameState &src);
+
+bool rectsOverlap(const Rect &a, const Rect &b);
+
+// Resolve disconnected clusters: unsupported components become falling
+// shapes. Only clusters containing a dirty cell are examined; every other
+// cluster was supported after the previous pass and cannot have changed.
+// Clusters that don't fit in the shape pool stay put until a later pass.
+// Clears the dirty set.
+void resolveFloatingClusters(Grid &grid,
+                             ShapePool &shapes,
+                             float fallSpeed,
+                             int pLeftCol,
+                             int pRightCol,
+                             int pTopRow,
+                             int pBotRow);
+
+// Pull cfg.cols/rows into the supported range.
+void clampBoardSize(GameConfig &cfg);
+
+// Back to a fresh game seeded with `seed`; keeps st.config (with the board
+// size clamped).
+void resetGame(GameState &st, std::uint64_t seed);
+
+// The shape the next spawn will drop, if the queue is in use.
+inline const SpawnSpec *nextSpawn(const GameState &st) {
+    return st.spawnCount ? &st.spawnQueue[st.spawnHead] : nullptr;
+}
+
+// Queue `rows` garbage rows, full but for column `hole`, to push the stack
+// up from the bottom at the start of the next step. Falling shapes and the
+// player rise with it; tiles pushed off the top end the game.
+void addGarbage(GameState &st, int rows, int hole);
+
+// Individual phases of step(), exposed for the benchmarks.
+void updateFallingShapes(GameState &st, float dt);
+void applyPower(GameState &st, BlockType type, int col, int row);
+int  clearFullRows(Grid &grid);   // returns the number of rows removed
+
+// Advance the simulation by dt seconds (normally TICK_DT) with the given
+// buttons held. Returns true on the step where the game ends. With a
+// profiler, each phase's time is added to its current frame.
+bool step(GameState &st, InputMask input, float dt, Profiler *prof = nullptr);
@@ -0,0 +1,295 @@
+// Headless batch runner: plays independent games through the simulation
+// core on every core, with no window, renderer or frame pacing.
+//
+//   headless [--games N] [--seed S] [--threads T] [--quiet] [--profile]
+//            [--spawn-interval SEC] [--powerup-gap SEC] [--freeze SEC]
+//            [--board COLSxROWS] [--bot]
+//   headless --replay FILE [--seek TICK]
+//   headless --replay FILE [--seek TICK] [--frames PREFIX] [--video FILE] [--fps N]
+//
+// Prints one CSV line per game (seed, survival, rows cleared, powerups
+// used) followed by aggregate statistics. Game i is seeded from S and i
+// alone, so results do not depend on the thread count. --profile adds the
+// mean time per tick of each simulation phase to the summary. --bot plays
+// every game with the search bot instead of the random stand-in; it is much
+// slower and, unlike the stand-in, actually tries to survive.
+//
+// --replay plays a recorded game back as fast as the core can step it and
+// prints its CSV line; with --seek it stops at that tick instead.
+//
+// --frames and --video render the replay offscreen with the software
+// rasterizer, at N frames per second of game time (default 60):
+// PREFIX00000.png, PREFIX00001.png, ... and/or one .y4m stream ("-" for
+// stdout). PNGs are encoded on every core.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bot.h"
+#include "capture.h"
+#include "framebuffer.h"
+#include "game.h"
+#include "input.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rng.h"
+
+static const float MAX_GAME_SEC = 600.0f;   // stop runaway games
+
+struct GameResult {
+    std::uint64_t seed;
+    float survival;
+    int   rowsCleared;
+    int   powerupsUsed;
+};
+
+static GameResult playGame(GameState &state, std::uint64_t seed, Bot *bot, Profiler *prof)
+{
+    resetGame(state, seed);
+
+    Rng botRng;
+    botRng.seed(seed, 0xb07);
+    if (bot) bot->reset(seed);
+    InputMask input = 0;
+    float holdTimer = 0.0f;
+
+    while (!state.gameOver && state.elapsedTime < MAX_GAME_SEC) {
+        holdTimer -= TICK_DT;
+        if (bot) {
+            input = bot->act(state);
+        } else if (holdTimer <= 0.0f) {
+            input = randomInput(botRng);
+            holdTimer = 0.25f;
+        }
+        if (prof) prof->beginFrame();
+        step(state, input, TICK_DT, prof);
+        if (prof) prof->endFrame();
+    }
+
+    GameResult res;
+    res.seed         = seed;
+    res.survival     = state.elapsedTime;
+    res.rowsCleared  = state.stats.rowsCleared;
+    res.powerupsUsed = state.stats.powerupsUsed;
+    return res;
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: headless [--games N] [--seed S] [--threads T] [--quiet] [--profile]\n"
+        "                [--spawn-interval SEC] [--powerup-gap SEC] [--freeze SEC]\n"
+        "                [--board COLSxROWS] [--bot]\n"
+        "       headless --replay FILE [--seek TICK]\n"
+        "       headless --replay FILE [--seek TICK] [--frames PREFIX] [--video FILE] [--fps N]\n");
+}
+
+static int playReplay(const char *path, long long seekTick)
+{
+    Replay replay;
+    if (!loadReplay(path, replay)) {
+        std::fprintf(stderr, "cannot read replay %s\n", path);
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ReplayPlayer player(replay);
+    if (seekTick >= 0) player.seek((std::uint32_t)seekTick);
+    else               player.runToEnd();
+    double wall = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    const GameState &st = player.state();
+    std::printf("seed,survival,rows_cleared,powerups_used\n");
+    std::printf("%llu,%.3f,%d,%d\n", (unsigned long long)replay.seed,
+                st.elapsedTime, st.stats.rowsCleared, st.stats.powerupsUsed);
+
+    std::fprintf(stderr, "replay:         %u ticks in %zu runs\n",
+                 replay.ticks, replay.runs.size());
+    std::fprintf(stderr, "stopped at:     tick %u%s\n", st.tick,
+                 st.gameOver ? " (game over)" : "");
+    std::fprintf(stderr, "wall time:      %.4f s\n", wall);
+    return 0;
+}
+
+static int exportReplay(const char *path, long long stopTick, const char *framesPrefix,
+                        const char *videoPath, int fps, int threads)
+{
+    Replay replay;
+    if (!loadReplay(path, replay)) {
+        std::fprintf(stderr, "cannot read replay %s\n", path);
+        return 1;
+    }
+    ReplayPlayer player(replay);
+    const std::uint32_t lastTick = stopTick >= 0 ? (std::uint32_t)stopTick : replay.ticks;
+    const int w = player.state().grid.pixelWidth(), h = player.state().grid.pixelHeight();
+
+    Y4mWriter video;
+    if (videoPath && !video.open(videoPath, w, h, fps)) {
+        std::fprintf(stderr, "cannot write %s\n", videoPath);
+        return 1;
+    }
+
+    // Frames are drawn in order, a batch at a time, and each batch is
+    // encoded in parallel.
+    const int batch = framesPrefix ? threads : 1;
+    std::vector<Image> images(batch);
+    for (Image &img : images) img.resize(w, h);
+    std::vector<int> failed(batch);
+
+    auto t0 = std::chrono::steady_clock::now();
+    int frames = 0;
+    bool ok = true, last = false;
+    while (!last && ok) {
+        int filled = 0;
+        for (; filled < batch && !last; ++filled) {
+            // Same interpolation as the game: up to the last whole tick,
+            // then `alpha` of the way into the next.
+            double t = (double)(frames + filled) * TICK_RATE / fps;
+            std::uint32_t target = std::min((std::uint32_t)t, lastTick);
+            while (player.state().tick < target && !player.done()) player.stepOnce();
+            last = player.done() || player.state().tick >= lastTick;
+            float alpha = last ? 1.0f : (float)(t - (double)target);
+            Framebuffer fb = images[filled].view();
+            drawPlayfieldPixels(fb, player.state(), alpha);
+            if (videoPath) ok = ok && video.write(images[filled]);
+        }
+        if (framesPrefix) {
+            parallelFor(filled, threads, [&](int k, int) {
+                char name[1024];
+                std::snprintf(name, sizeof(name), "%s%05d.png", framesPrefix, frames + k);
+                failed[k] = !writePng(name, images[k]);
+            });
+            for (int k = 0; k < filled; ++k) ok = ok && !failed[k];
+        }
+        frames += filled;
+    }
+    if (videoPath) ok = video.close() && ok;
+    double wall = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    if (!ok) {
+        std::fprintf(stderr, "writing frames failed after %d\n", frames);
+        return 1;
+    }
+
+    double gameSec = (double)player.state().tick / TICK_RATE;
+    std::fprintf(stderr, "exported:       %d frames of %dx%d at %d fps (%.1f s of play)\n",
+                 frames, w, h, fps, gameSec);
+    std::fprintf(stderr, "wall time:      %.3f s (%.0f frames/s, %.1fx real time)\n",
+                 wall, frames / wall, gameSec / wall);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int games = 1000;
+    std::uint64_t baseSeed = 1;
+    int threads = defaultThreadCount();
+    bool quiet = false;
+    bool profile = false;
+    bool useBot = false;
+    GameConfig config;
+    const char *replayPath = nullptr;
+    long long seekTick = -1;
+    const char *framesPrefix = nullptr;
+    const char *videoPath = nullptr;
+    int fps = 60;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(a, "--quiet") == 0)   { quiet = true; continue; }
+        if (std::strcmp(a, "--profile") == 0) { profile = true; continue; }
+        if (std::strcmp(a, "--bot") == 0)     { useBot = true; continue; }
+        if (!v) { usage(); return 1; }
+        if      (std::strcmp(a, "--games") == 0)          games = std::atoi(v);
+        else if (std::strcmp(a, "--seed") == 0)           baseSeed = std::strtoull(v, nullptr, 10);
+        else if (std::strcmp(a, "--threads") == 0)        threads = std::atoi(v);
+        else if (std::strcmp(a, "--spawn-interval") == 0) config.spawnInterval = (float)std::atof(v);
+        else if (std::strcmp(a, "--powerup-gap") == 0)    config.powerupMaxGap = (float)std::atof(v);
+        else if (std::strcmp(a, "--freeze") == 0)         config.freezeDuration = (float)std::atof(v);
+        else if (std::strcmp(a, "--board") == 0) {
+            if (std::sscanf(v, "%dx%d", &config.cols, &config.rows) != 2) { usage(); return 1; }
+        }
+        else if (std::strcmp(a, "--replay") == 0)         replayPath = v;
+        else if (std::strcmp(a, "--seek") == 0)           seekTick = std::atoll(v);
+        else if (std::strcmp(a, "--frames") == 0)         framesPrefix = v;
+        else if (std::strcmp(a, "--video") == 0)          videoPath = v;
+        else if (std::strcmp(a, "--fps") == 0)            fps = std::atoi(v);
+        else { usage(); return 1; }
+        ++i;
+    }
+    if (threads <= 0) threads = 1;
+    if (replayPath && (framesPrefix || videoPath))
+        return exportReplay(replayPath, seekTick, framesPrefix, videoPath,
+                            std::max(fps, 1), threads);
+    if (replayPath) return playReplay(replayPath, seekTick);
+    if (games <= 0) games = 1;
+
+    std::vector<GameResult> results(games);
+    // One state per worker, reset for each of its games, so games running
+    // at once never share one.
+    std::vector<GameState> states(threads);
+    clampBoardSize(config);
+    for (auto &st : states) st.config = config;
+    std::vector<Profiler> profilers(profile ? threads : 0);
+    // Games already use every core, so each bot searches on one thread.
+    std::vector<Bot> bots(useBot ? threads : 0);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    parallelFor(games, threads, [&](int g, int worker) {
+        results[g] = playGame(states[worker], mixSeed(baseSeed + (std::uint64_t)g),
+                              useBot ? &bots[worker] : nullptr,
+                              profile ? &profilers[worker] : nullptr);
+    });
+
+    double wall = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    if (!quiet) {
+        std::printf("seed,survival,rows_cleared,powerups_used\n");
+        for (const auto &r : results)
+            std::printf("%llu,%.3f,%d,%d\n", (unsigned long long)r.seed,
+                        r.survival, r.rowsCleared, r.powerupsUsed);
+    }
+
+    std::vector<float> survival;
+    survival.reserve(games);
+    double simTotal = 0.0, rowsTotal = 0.0, powerTotal = 0.0;
+    for (const auto &r : results) {
+        survival.push_back(r.survival);
+        simTotal   += r.survival;
+        rowsTotal  += r.rowsCleared;
+        powerTotal += r.powerupsUsed;
+    }
+    std::sort(survival.begin(), survival.end());
+
+    std::fprintf(stderr, "games:          %d on %d threads\n", games, threads);
+    std::fprintf(stderr, "config:         board %dx%d  spawn-interval %.3f  powerup-gap %.2f  freeze %.2f\n",
+                 config.cols, config.rows,
+                 config.spawnInterval, config.powerupMaxGap, config.freezeDuration);
+    std::fprintf(stderr, "survival:       mean %.2f  median %.2f  min %.2f  max %.2f s\n",
+                 simTotal / games, survival[games / 2], survival.front(), survival.back());
+    std::fprintf(stderr, "rows cleared:   mean %.2f\n", rowsTotal / games);
+    std::fprintf(stderr, "powerups used:  mean %.2f\n", powerTotal / games);
+    std::fprintf(stderr, "wall time:      %.3f s (%.0f games/s, %.0fx real time)\n",
+                 wall, games / wall, simTotal / wall);
+
+    if (profile) {
+        Profiler all;
+        for (const auto &p : profilers) all.merge(p);
+        double ticks = (double)std::max<std::uint64_t>(1, all.frames());
+        std::fprintf(stderr, "phase (us/tick):");
+        for (int p = PHASE_PLAYER; p <= PHASE_GAME_OVER; ++p)
+            std::fprintf(stderr, " %s %.3f", phaseName((ProfPhase)p),
+                         all.totalUs((ProfPhase)p) / ticks);
+        std::fprintf(stderr, "\n");
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// Timestamped button transitions, replayed into the fixed-step simulation.
+// The frontend queues presses and releases as they arrive from the event
+// queue; each tick then takes the buttons as of its own end time, so a
+// press lands on the tick it happened in rather than the next frame's.
+// Times are milliseconds on any clock the caller uses consistently.
+//
+// randomInput() is the stand-in player shared by the headless runner and
+// the tournament client, which relies on both playing alike.
+
+#include <cstddef>
+#include <vector>
+
+#include "game.h"
+
+// A random set of buttons; callers re-roll it a few times a second. Good
+// enough to exercise every code path.
+inline InputMask randomInput(Rng &rng) {
+    InputMask in = 0;
+    int move = rng.below(3);
+    if (move == 1) in |= INPUT_LEFT;
+    if (move == 2) in |= INPUT_RIGHT;
+    if (rng.below(4) == 0) in |= INPUT_JUMP;
+    if (rng.below(3) == 0) in |= (InputMask)(INPUT_BREAK_LEFT << rng.below(4));
+    return in;
+}
+
+class InputTimeline {
+public:
+    void press(InputMask bits, double t)   { events.push_back(Event{ t, bits, true }); }
+    void release(InputMask bits, double t) { events.push_back(Event{ t, bits, false }); }
+
+    // Buttons for the tick ending at time t: everything held at t, plus
+    // anything pressed since the previous sample, so a tap shorter than a
+    // tick still registers. Later events stay queued.
+    InputMask sample(double t) {
+        InputMask tapped = 0;
+        for (; head < events.size() && events[head].t <= t; ++head) {
+            const Event &e = events[head];
+            if (e.down) { held |= e.bits; tapped |= e.bits; }
+            else        held &= (InputMask)~e.bits;
+        }
+        if (head == events.size()) {
+            events.clear();
+            head = 0;
+        }
+        return held | tapped;
+    }
+
+    bool pending() const { return head < events.size(); }
+
+    // Drop queued events and take `buttons` as the held set, e.g. from the
+    // keyboard state when nothing is pending or after focus changes.
+    void reset(InputMask buttons) {
+        events.clear();
+        head = 0;
+        held = buttons;
+    }
+
+private:
+    struct Event {
+        double    t;
+        InputMask bits;
+        bool      down;
+    };
+
+    std::vector<Event> events;       // in time order; [head, end) not yet applied
+    std::size_t head = 0;
+    InputMask held = 0;
+};
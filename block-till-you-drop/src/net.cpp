@@ -0,0 +1,272 @@
+#include "net.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+static const std::intptr_t NO_SOCKET = (std::intptr_t)INVALID_SOCKET;
+static void closeSocket(std::intptr_t s) { closesocket((NativeSocket)s); }
+static bool setNonBlocking(std::intptr_t s)
+{
+    u_long on = 1;
+    return ioctlsocket((NativeSocket)s, FIONBIO, &on) == 0;
+}
+static bool connectPending() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static const int SEND_FLAGS = 0;
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+static const std::intptr_t NO_SOCKET = -1;
+static void closeSocket(std::intptr_t s) { close((int)s); }
+static bool setNonBlocking(std::intptr_t s)
+{
+    int flags = fcntl((int)s, F_GETFL, 0);
+    return flags >= 0 && fcntl((int)s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+static bool connectPending() { return errno == EINPROGRESS; }
+#if defined(MSG_NOSIGNAL)
+static const int SEND_FLAGS = MSG_NOSIGNAL;    // a dropped connection is an error, not SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+#endif
+
+static_assert(sizeof(sockaddr_storage) <= 128, "UdpPeer::peer too small");
+
+UdpPeer::UdpPeer() : sock(NO_SOCKET)
+{
+#if defined(_WIN32)
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+UdpPeer::~UdpPeer()
+{
+    if (sock != NO_SOCKET) closeSocket(sock);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+// Non-blocking IPv4 UDP socket bound to `port` on all interfaces (0 for any
+// free port), or NO_SOCKET.
+static std::intptr_t openUdp(std::uint16_t port)
+{
+    std::intptr_t s = (std::intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == NO_SOCKET) return NO_SOCKET;
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind((NativeSocket)s, (const sockaddr *)&addr, sizeof(addr)) != 0 || !setNonBlocking(s)) {
+        closeSocket(s);
+        return NO_SOCKET;
+    }
+    return s;
+}
+
+bool UdpPeer::open(std::uint16_t port)
+{
+    sock = openUdp(port);
+    return sock != NO_SOCKET;
+}
+
+bool UdpPeer::host(std::uint16_t port)
+{
+    return open(port);
+}
+
+bool UdpPeer::join(const char *hostName, std::uint16_t port)
+{
+    addrinfo hints, *found = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    char service[8];
+    std::snprintf(service, sizeof(service), "%u", (unsigned)port);
+    if (getaddrinfo(hostName, service, &hints, &found) != 0 || !found) return false;
+
+    bool ok = open(0) && found->ai_addrlen <= sizeof(peer);
+    if (ok) {
+        std::memcpy(peer, found->ai_addr, found->ai_addrlen);
+        peerLen = (int)found->ai_addrlen;
+        peerKnown = true;
+    }
+    freeaddrinfo(found);
+    return ok;
+}
+
+bool UdpPeer::send(const void *data, std::size_t size)
+{
+    if (sock == NO_SOCKET || !peerKnown) return false;
+    return sendto((NativeSocket)sock, (const char *)data, (int)size, 0,
+                  (const sockaddr *)peer, (socklen_t)peerLen) == (int)size;
+}
+
+int UdpPeer::receive(void *buf, std::size_t capacity)
+{
+    if (sock == NO_SOCKET) return -1;
+    for (;;) {
+        sockaddr_storage from;
+        socklen_t fromLen = sizeof(from);
+        int n = (int)recvfrom((NativeSocket)sock, (char *)buf, (int)capacity, 0,
+                              (sockaddr *)&from, &fromLen);
+        if (n < 0) return -1;
+        if (!peerKnown) {
+            std::memcpy(peer, &from, (std::size_t)fromLen);
+            peerLen = (int)fromLen;
+            peerKnown = true;
+            return n;
+        }
+        if ((int)fromLen == peerLen && std::memcmp(&from, peer, (std::size_t)fromLen) == 0)
+            return n;
+    }
+}
+
+static bool waitFor(std::intptr_t s, bool write, int timeoutMs)
+{
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET((NativeSocket)s, &set);
+    timeval tv;
+    tv.tv_sec  = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    return select((int)((NativeSocket)s + 1), write ? nullptr : &set,
+                  write ? &set : nullptr, nullptr, &tv) == 1;
+}
+
+static bool waitWritable(std::intptr_t s, int timeoutMs)
+{
+    return waitFor(s, true, timeoutMs);
+}
+
+UdpSocket::UdpSocket() : sock(NO_SOCKET)
+{
+#if defined(_WIN32)
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+bool UdpSocket::open(std::uint16_t port)
+{
+    close();
+    sock = openUdp(port);
+    return sock != NO_SOCKET;
+}
+
+void UdpSocket::close()
+{
+    if (sock != NO_SOCKET) closeSocket(sock);
+    sock = NO_SOCKET;
+}
+
+bool UdpSocket::sendTo(const NetAddress &to, const void *data, std::size_t size)
+{
+    if (sock == NO_SOCKET) return false;
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(to.ip);
+    addr.sin_port = htons(to.port);
+    return sendto((NativeSocket)sock, (const char *)data, (int)size, 0,
+                  (const sockaddr *)&addr, (socklen_t)sizeof(addr)) == (int)size;
+}
+
+int UdpSocket::receiveFrom(void *buf, std::size_t capacity, NetAddress &from)
+{
+    if (sock == NO_SOCKET) return -1;
+    sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    int n = (int)recvfrom((NativeSocket)sock, (char *)buf, (int)capacity, 0,
+                          (sockaddr *)&addr, &addrLen);
+    if (n < 0) return -1;
+    from.ip = ntohl(addr.sin_addr.s_addr);
+    from.port = ntohs(addr.sin_port);
+    return n;
+}
+
+bool UdpSocket::waitReadable(int timeoutMs)
+{
+    return sock != NO_SOCKET && waitFor(sock, false, timeoutMs);
+}
+
+bool sendOverTcp(const char *hostName, std::uint16_t port,
+                 const void *data, std::size_t size, int timeoutMs)
+{
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    addrinfo hints, *found = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    std::snprintf(service, sizeof(service), "%u", (unsigned)port);
+    bool ok = getaddrinfo(hostName, service, &hints, &found) == 0 && found;
+
+    std::intptr_t sock = NO_SOCKET;
+    if (ok) {
+        sock = (std::intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        ok = sock != NO_SOCKET && setNonBlocking(sock);
+    }
+#if defined(SO_NOSIGPIPE)
+    if (ok) {
+        int on = 1;
+        setsockopt((NativeSocket)sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    // Non-blocking connect, so an unreachable server costs timeoutMs rather
+    // than the system's connect timeout.
+    if (ok && connect((NativeSocket)sock, found->ai_addr, (socklen_t)found->ai_addrlen) != 0) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        ok = connectPending() && waitWritable(sock, timeoutMs) &&
+             getsockopt((NativeSocket)sock, SOL_SOCKET, SO_ERROR, (char *)&err, &len) == 0 && err == 0;
+    }
+
+    const char *p = (const char *)data;
+    while (ok && size > 0) {
+        if (!waitWritable(sock, timeoutMs)) {
+            ok = false;
+            break;
+        }
+        int chunk = size > 65536 ? 65536 : (int)size;
+        int n = (int)::send((NativeSocket)sock, p, chunk, SEND_FLAGS);
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        p += n;
+        size -= (std::size_t)n;
+    }
+
+    if (sock != NO_SOCKET) closeSocket(sock);
+    if (found) freeaddrinfo(found);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    return ok;
+}
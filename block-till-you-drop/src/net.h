@@ -0,0 +1,77 @@
+#pragma once
+
+// Minimal sockets for versus play, the tournament server and telemetry.
+// UdpPeer is a non-blocking UDP endpoint with one socket and one peer: the
+// hosting side learns its peer from the first datagram it receives, the
+// joining side sends to the address it was given. UdpSocket serves any
+// number of peers, each told apart by its address. sendOverTcp() delivers
+// one message and hangs up.
+
+#include <cstddef>
+#include <cstdint>
+
+class UdpPeer {
+public:
+    UdpPeer();
+    ~UdpPeer();
+    UdpPeer(const UdpPeer &) = delete;
+    UdpPeer &operator=(const UdpPeer &) = delete;
+
+    bool host(std::uint16_t port);
+    bool join(const char *hostName, std::uint16_t port);
+
+    bool hasPeer() const { return peerKnown; }
+
+    // Fire and forget; false if there is no peer yet or the send failed.
+    bool send(const void *data, std::size_t size);
+
+    // Next datagram from the peer, or -1 if none is waiting. Datagrams
+    // from anyone else are dropped once a peer is known.
+    int receive(void *buf, std::size_t capacity);
+
+private:
+    bool open(std::uint16_t port);
+
+    std::intptr_t sock;
+    bool peerKnown = false;
+    alignas(8) unsigned char peer[128];    // sockaddr_storage
+    int peerLen = 0;
+};
+
+// IPv4 address and port, in host byte order.
+struct NetAddress {
+    std::uint32_t ip = 0;
+    std::uint16_t port = 0;
+
+    std::uint64_t key() const { return ((std::uint64_t)ip << 16) | port; }
+};
+
+class UdpSocket {
+public:
+    UdpSocket();
+    ~UdpSocket();
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator=(const UdpSocket &) = delete;
+
+    // Bind to `port` on all interfaces.
+    bool open(std::uint16_t port);
+    void close();
+
+    // Safe to call from several threads at once.
+    bool sendTo(const NetAddress &to, const void *data, std::size_t size);
+
+    // Next datagram and its sender, or -1 if none is waiting.
+    int receiveFrom(void *buf, std::size_t capacity, NetAddress &from);
+
+    // Block until a datagram is waiting or timeoutMs passes.
+    bool waitReadable(int timeoutMs);
+
+private:
+    std::intptr_t sock;
+};
+
+// Connect to hostName:port over TCP, send the bytes and close. Blocks for up
+// to timeoutMs each on connecting and sending, so call it off the frame
+// loop. True only if everything was handed to the network.
+bool sendOverTcp(const char *hostName, std::uint16_t port,
+                 const void *data, std::size_t size, int timeoutMs);
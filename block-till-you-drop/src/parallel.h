@@ -0,0 +1,162 @@
+#pragma once
+
+// Minimal work-stealing parallel loop for coarse, independent jobs such as
+// whole headless games, and a persistent pool for short loops run every
+// frame.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline int defaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? (int)n : 1;
+}
+
+// Runs fn(i, worker) for every i in [0, n) on up to `threads` workers.
+// Each worker starts on its own contiguous slice; once that runs dry it
+// steals the upper half of whatever another worker has left.
+template <class Fn>
+void parallelFor(int n, int threads, Fn fn)
+{
+    if (n <= 0) return;
+    threads = std::max(1, std::min(threads, n));
+    if (threads == 1) {
+        for (int i = 0; i < n; ++i) fn(i, 0);
+        return;
+    }
+
+    struct alignas(64) Slice {
+        std::mutex m;
+        int begin, end;
+    };
+    std::vector<Slice> slices(threads);
+    for (int w = 0; w < threads; ++w) {
+        slices[w].begin = (int)((long long)n * w / threads);
+        slices[w].end   = (int)((long long)n * (w + 1) / threads);
+    }
+
+    auto popOwn = [&](int w, int &out) -> bool {
+        std::lock_guard<std::mutex> lock(slices[w].m);
+        if (slices[w].begin >= slices[w].end) return false;
+        out = slices[w].begin++;
+        return true;
+    };
+
+    auto steal = [&](int w) -> bool {
+        for (int k = 1; k < threads; ++k) {
+            Slice &victim = slices[(w + k) % threads];
+            int b, e;
+            {
+                std::lock_guard<std::mutex> lock(victim.m);
+                int left = victim.end - victim.begin;
+                if (left <= 0) continue;
+                e = victim.end;
+                b = victim.end - (left + 1) / 2;
+                victim.end = b;
+            }
+            std::lock_guard<std::mutex> lock(slices[w].m);
+            slices[w].begin = b;
+            slices[w].end   = e;
+            return true;
+        }
+        return false;
+    };
+
+    auto worker = [&](int w) {
+        int i;
+        for (;;) {
+            while (popOwn(w, i)) fn(i, w);
+            if (!steal(w)) return;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+    worker(0);
+    for (auto &t : pool) t.join();
+}
+
+// A fixed set of threads for parallel loops short enough that starting
+// threads per call (as parallelFor does) would eat the time saved. run()
+// hands indices out from a shared counter and returns when all are done;
+// the calling thread works too, as worker 0. Nothing is allocated per run.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads) {
+        for (int w = 1; w < threads; ++w) pool.emplace_back(&WorkerPool::work, this, w);
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto &t : pool) t.join();
+    }
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    int size() const { return (int)pool.size() + 1; }
+
+    // Runs fn(i, worker) for every i in [0, n); fn must outlive the call.
+    template <class Fn>
+    void run(int n, Fn &fn) {
+        if (n <= 0) return;
+        if (pool.empty()) {
+            for (int i = 0; i < n; ++i) fn(i, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            call = [](void *ctx, int i, int w) { (*static_cast<Fn *>(ctx))(i, w); };
+            ctx = &fn;
+            jobSize = n;
+            next.store(0, std::memory_order_relaxed);
+            busy = (int)pool.size();
+            ++generation;
+        }
+        wake.notify_all();
+        drain(0);
+        std::unique_lock<std::mutex> lock(m);
+        idle.wait(lock, [this] { return busy == 0; });
+    }
+
+private:
+    void drain(int w) {
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < jobSize; )
+            call(ctx, i, w);
+    }
+
+    void work(int w) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                wake.wait(lock, [&] { return quit || generation != seen; });
+                if (quit) return;
+                seen = generation;
+            }
+            drain(w);
+            std::lock_guard<std::mutex> lock(m);
+            if (--busy == 0) idle.notify_one();
+        }
+    }
+
+    std::vector<std::thread> pool;
+    std::mutex m;
+    std::condition_variable wake, idle;
+    std::uint64_t generation = 0;
+    bool quit = false;
+    int busy = 0;
+
+    void (*call)(void *, int, int) = nullptr;
+    void *ctx = nullptr;
+    int jobSize = 0;
+    std::atomic<int> next{ 0 };
+};
@@ -0,0 +1,133 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const char *phaseName(ProfPhase phase)
+{
+    static const char *const NAMES[PHASE_COUNT] = {
+        "input", "player", "spawn", "falling", "abilities",
+        "row_clear", "clusters", "game_over", "render", "present"
+    };
+    return (phase >= 0 && phase < PHASE_COUNT) ? NAMES[phase] : "?";
+}
+
+Profiler::Profiler() : origin(Clock::now())
+{
+    std::fill(current, current + PHASE_COUNT, 0.0f);
+    std::fill(total, total + PHASE_COUNT, 0.0);
+    for (auto &h : history) std::fill(h, h + HISTORY, 0.0f);
+}
+
+void Profiler::beginFrame()
+{
+    std::fill(current, current + PHASE_COUNT, 0.0f);
+}
+
+void Profiler::endFrame()
+{
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        history[p][head] = current[p];
+        total[p] += current[p];
+    }
+    head = (head + 1) % HISTORY;
+    filled = std::min(filled + 1, HISTORY);
+    ++frameCount;
+
+    if (capture) {
+        captureRows.insert(captureRows.end(), current, current + PHASE_COUNT);
+        ++captureFrame;
+    }
+}
+
+void Profiler::add(ProfPhase phase, Clock::time_point start, Clock::time_point end)
+{
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    current[phase] += (float)us;
+    if (capture) {
+        double at = std::chrono::duration<double, std::micro>(start - origin).count();
+        trace.push_back(TraceEvent{ (std::uint8_t)phase, captureFrame, at, us });
+    }
+}
+
+PhaseStats Profiler::stats(ProfPhase phase) const
+{
+    PhaseStats s{ 0.0, 0.0 };
+    if (filled == 0) return s;
+
+    float sorted[HISTORY];
+    double sum = 0.0;
+    for (int i = 0; i < filled; ++i) {
+        sorted[i] = history[phase][i];
+        sum += sorted[i];
+    }
+    int k = std::min(filled - 1, filled * 99 / 100);
+    std::nth_element(sorted, sorted + k, sorted + filled);
+    s.avgUs = sum / filled;
+    s.p99Us = sorted[k];
+    return s;
+}
+
+double Profiler::frameAvgUs() const
+{
+    double sum = 0.0;
+    for (int p = 0; p < PHASE_COUNT; ++p)
+        for (int i = 0; i < filled; ++i) sum += history[p][i];
+    return filled ? sum / filled : 0.0;
+}
+
+void Profiler::merge(const Profiler &other)
+{
+    for (int p = 0; p < PHASE_COUNT; ++p) total[p] += other.total[p];
+    frameCount += other.frameCount;
+}
+
+void Profiler::startCapture()
+{
+    captureRows.clear();
+    trace.clear();
+    captureFrame = 0;
+    capture = true;
+}
+
+void Profiler::stopCapture()
+{
+    capture = false;
+}
+
+bool Profiler::writeCsv(const char *path) const
+{
+    std::FILE *f = std::fopen(path, "w");
+    if (!f) return false;
+
+    std::fprintf(f, "frame");
+    for (int p = 0; p < PHASE_COUNT; ++p) std::fprintf(f, ",%s_us", phaseName((ProfPhase)p));
+    std::fprintf(f, "\n");
+
+    std::size_t rows = captureRows.size() / PHASE_COUNT;
+    for (std::size_t r = 0; r < rows; ++r) {
+        std::fprintf(f, "%zu", r);
+        for (int p = 0; p < PHASE_COUNT; ++p)
+            std::fprintf(f, ",%.2f", captureRows[r * PHASE_COUNT + p]);
+        std::fprintf(f, "\n");
+    }
+    return std::fclose(f) == 0;
+}
+
+// Chrome trace-event JSON: load in chrome://tracing or Perfetto.
+bool Profiler::writeTrace(const char *path) const
+{
+    std::FILE *f = std::fopen(path, "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\"traceEvents\":[\n");
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const TraceEvent &e = trace[i];
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}%s\n",
+                     phaseName((ProfPhase)e.phase), e.startUs, e.durUs, e.frame,
+                     i + 1 < trace.size() ? "," : "");
+    }
+    std::fprintf(f, "]}\n");
+    return std::fclose(f) == 0;
+}
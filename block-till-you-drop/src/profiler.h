@@ -0,0 +1,96 @@
+#pragma once
+
+// Per-phase frame profiler. Scoped timers add their duration to the current
+// frame; the last HISTORY frames are kept for rolling averages and p99, and
+// a capture can be dumped as per-frame CSV or a Chrome trace-event file.
+// Plain std::chrono, so the engine and headless runner can use it too.
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+enum ProfPhase {
+    PHASE_INPUT,
+    PHASE_PLAYER,
+    PHASE_SPAWN,
+    PHASE_FALLING,
+    PHASE_ABILITIES,
+    PHASE_ROW_CLEAR,
+    PHASE_CLUSTERS,
+    PHASE_GAME_OVER,
+    PHASE_RENDER,
+    PHASE_PRESENT,
+    PHASE_COUNT
+};
+
+const char *phaseName(ProfPhase phase);
+
+struct PhaseStats {
+    double avgUs, p99Us;
+};
+
+class Profiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+    static const int HISTORY = 240;    // frames
+
+    Profiler();
+
+    void beginFrame();
+    void endFrame();
+    void add(ProfPhase phase, Clock::time_point start, Clock::time_point end);
+
+    // Over the last HISTORY frames.
+    PhaseStats stats(ProfPhase phase) const;
+    double frameAvgUs() const;
+
+    // Since construction, for whole-run summaries.
+    double totalUs(ProfPhase phase) const { return total[phase]; }
+    std::uint64_t frames() const { return frameCount; }
+    void merge(const Profiler &other);
+
+    // Capture every frame and scope until stopCapture(); then dump.
+    void startCapture();
+    void stopCapture();
+    bool capturing() const { return capture; }
+    bool writeCsv(const char *path) const;
+    bool writeTrace(const char *path) const;
+
+private:
+    struct TraceEvent {
+        std::uint8_t  phase;
+        std::uint32_t frame;
+        double        startUs, durUs;
+    };
+
+    Clock::time_point origin;
+    float  current[PHASE_COUNT];
+    float  history[PHASE_COUNT][HISTORY];  // microseconds per frame
+    int    head = 0, filled = 0;
+    double total[PHASE_COUNT];
+    std::uint64_t frameCount = 0;
+
+    bool capture = false;
+    std::uint32_t captureFrame = 0;
+    std::vector<float> captureRows;        // PHASE_COUNT per captured frame
+    std::vector<TraceEvent> trace;
+};
+
+// Times the enclosing scope into `prof`'s current frame; a null profiler
+// costs one branch.
+class ProfileScope {
+public:
+    ProfileScope(Profiler *prof, ProfPhase phase) : prof(prof), phase(phase) {
+        if (prof) start = Profiler::Clock::now();
+    }
+    ~ProfileScope() {
+        if (prof) prof->add(phase, start, Profiler::Clock::now());
+    }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    Profiler *prof;
+    ProfPhase phase;
+    Profiler::Clock::time_point start;
+};
@@ -0,0 +1,583 @@
+#include "render.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static const int ATLAS_TYPES = LASER_V + 1;
+
+static void drawBombIcon(SDL_Renderer *renderer, SDL_Rect r) {
+    int margin = r.w / 4;
+    SDL_Rect core{ r.x + margin, r.y + margin,
+                   r.w - 2*margin, r.h - 2*margin };
+    SDL_SetRenderDrawColor(renderer, 40,40,40,255);
+    SDL_RenderFillRect(renderer, &core);
+}
+
+static void drawFreezeIcon(SDL_Renderer *renderer, SDL_Rect r) {
+    SDL_SetRenderDrawColor(renderer, 255,255,255,255);
+    int cx = r.x + r.w/2;
+    int cy = r.y + r.h/2;
+    SDL_RenderDrawLine(renderer, cx - r.w/3, cy, cx + r.w/3, cy);
+    SDL_RenderDrawLine(renderer, cx, cy - r.h/3, cx, cy + r.h/3);
+}
+
+static void drawLaserHIcon(SDL_Renderer *renderer, SDL_Rect r) {
+    SDL_SetRenderDrawColor(renderer, 255,50,50,255);
+    int mid = r.y + r.h/2;
+    SDL_Rect stripe{ r.x + 2, mid - 2, r.w - 4, 4 };
+    SDL_RenderFillRect(renderer, &stripe);
+}
+
+static void drawLaserVIcon(SDL_Renderer *renderer, SDL_Rect r) {
+    SDL_SetRenderDrawColor(renderer, 255,50,50,255);
+    int mid = r.x + r.w/2;
+    SDL_Rect stripe{ mid - 2, r.y + 2, 4, r.h - 4 };
+    SDL_RenderFillRect(renderer, &stripe);
+}
+
+// Immediate-mode tile: used to bake the atlas and as the fallback path.
+static void drawTile(SDL_Renderer *renderer, SDL_Rect r, BlockType type, bool falling)
+{
+    Rgb fill = tileColor(type, falling);
+    SDL_SetRenderDrawColor(renderer, fill.r, fill.g, fill.b, 255);
+    SDL_RenderFillRect(renderer, &r);
+
+    switch (type) {
+        case NORMAL:                                   break;
+        case BOMB:    drawBombIcon(renderer, r);       break;
+        case FREEZE:  drawFreezeIcon(renderer, r);     break;
+        case LASER_H: drawLaserHIcon(renderer, r);     break;
+        case LASER_V: drawLaserVIcon(renderer, r);     break;
+    }
+}
+
+bool createTileAtlas(SDL_Renderer *renderer, TileAtlas &atlas)
+{
+    destroyTileAtlas(atlas);
+
+    SDL_Texture *tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                         SDL_TEXTUREACCESS_TARGET,
+                                         ATLAS_TYPES * CELL, 2 * CELL);
+    if (!tex) {
+        SDL_Log("Tile atlas unavailable, drawing tiles directly: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_Texture *prevTarget = SDL_GetRenderTarget(renderer);
+    if (SDL_SetRenderTarget(renderer, tex) != 0) {
+        SDL_Log("Tile atlas unavailable, drawing tiles directly: %s", SDL_GetError());
+        SDL_DestroyTexture(tex);
+        return false;
+    }
+
+    // Row 0: static variants, row 1: falling variants.
+    for (int t = 0; t < ATLAS_TYPES; ++t) {
+        drawTile(renderer, SDL_Rect{ t * CELL, 0,    CELL, CELL }, (BlockType)t, false);
+        drawTile(renderer, SDL_Rect{ t * CELL, CELL, CELL, CELL }, (BlockType)t, true);
+    }
+    SDL_SetRenderTarget(renderer, prevTarget);
+
+    atlas.texture = tex;
+    return true;
+}
+
+void destroyTileAtlas(TileAtlas &atlas)
+{
+    if (atlas.texture) {
+        SDL_DestroyTexture(atlas.texture);
+        atlas.texture = nullptr;
+    }
+    atlas.verts.clear();
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+// Index and vertex buffers only grow, to the most quads a frame has needed,
+// so steady-state frames don't allocate.
+static void reserveQuads(TileAtlas &atlas, int quads)
+{
+    int have = (int)atlas.indices.size() / 6;
+    if (quads <= have) return;
+    atlas.verts.reserve((std::size_t)quads * 4);
+    atlas.indices.resize((std::size_t)quads * 6);
+    for (int q = have; q < quads; ++q) {
+        int *ix = &atlas.indices[q * 6];
+        int v = q * 4;
+        ix[0] = v;     ix[1] = v + 1; ix[2] = v + 2;
+        ix[3] = v + 2; ix[4] = v + 1; ix[5] = v + 3;
+    }
+}
+
+static void pushQuad(TileAtlas &atlas, float x, float y, BlockType type, bool falling)
+{
+    const float tw = 1.0f / ATLAS_TYPES;
+    const float th = 0.5f;
+    float u0 = type * tw, u1 = u0 + tw;
+    float v0 = falling ? th : 0.0f, v1 = v0 + th;
+    SDL_Color white{255,255,255,255};
+
+    atlas.verts.push_back(SDL_Vertex{ { x,        y        }, white, { u0, v0 } });
+    atlas.verts.push_back(SDL_Vertex{ { x + CELL, y        }, white, { u1, v0 } });
+    atlas.verts.push_back(SDL_Vertex{ { x,        y + CELL }, white, { u0, v1 } });
+    atlas.verts.push_back(SDL_Vertex{ { x + CELL, y + CELL }, white, { u1, v1 } });
+}
+#else
+static void copyTile(SDL_Renderer *renderer, TileAtlas &atlas,
+                     int x, int y, BlockType type, bool falling)
+{
+    SDL_Rect src{ type * CELL, falling ? CELL : 0, CELL, CELL };
+    SDL_Rect dst{ x, y, CELL, CELL };
+    SDL_RenderCopy(renderer, atlas.texture, &src, &dst);
+}
+#endif
+
+static float shapeY(const FallingShape &s, float alpha)
+{
+    return s.prevY + (s.y - s.prevY) * alpha;
+}
+
+// Queue atlas tiles for `cells` of one grid row, or copy them straight out
+// without SDL_RenderGeometry; flushQuads() sends the queue.
+static void addStaticCells(SDL_Renderer *renderer, TileAtlas &atlas, const Grid &grid,
+                           int row, RowMask cells)
+{
+    for (RowMask m = cells; m; m &= m - 1) {
+        int col = ctz64(m);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        (void)renderer;
+        pushQuad(atlas, (float)(col * CELL), (float)(row * CELL), grid.typeAt(col, row), false);
+#else
+        copyTile(renderer, atlas, col * CELL, row * CELL, grid.typeAt(col, row), false);
+#endif
+    }
+}
+
+// Same for every falling cell, at its interpolated position.
+static void addFallingCells(SDL_Renderer *renderer, TileAtlas &atlas, const ShapePool &pool,
+                            float alpha)
+{
+    for (int k = 0; k < pool.shapeCount; ++k) {
+        const FallingShape &s = pool.shapes[k];
+        for (int i = s.first; i < s.first + s.count; ++i) {
+            ShapeCell cell = pool.cells[i];
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+            (void)renderer;
+            pushQuad(atlas, (float)(int)(s.x + cellDx(cell) * CELL),
+                     (float)(int)(shapeY(s, alpha) + cellDy(cell) * CELL),
+                     cellType(cell), true);
+#else
+            copyTile(renderer, atlas, (int)(s.x + cellDx(cell) * CELL),
+                     (int)(shapeY(s, alpha) + cellDy(cell) * CELL), cellType(cell), true);
+#endif
+        }
+    }
+}
+
+static void flushQuads(SDL_Renderer *renderer, TileAtlas &atlas)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int quads = (int)atlas.verts.size() / 4;
+    if (quads > 0)
+        SDL_RenderGeometry(renderer, atlas.texture,
+                           atlas.verts.data(), (int)atlas.verts.size(),
+                           atlas.indices.data(), quads * 6);
+    atlas.verts.clear();
+#else
+    // No SDL_RenderGeometry: same-texture copies still coalesce in SDL's
+    // render batching.
+    (void)renderer;
+    (void)atlas;
+#endif
+}
+
+bool createStaticLayer(SDL_Renderer *renderer, int cols, int rows, StaticLayer &layer)
+{
+    destroyStaticLayer(layer);
+
+    SDL_Texture *tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                         SDL_TEXTUREACCESS_TARGET,
+                                         cols * CELL, rows * CELL);
+    if (!tex) {
+        SDL_Log("Static layer unavailable, redrawing the stack each frame: %s", SDL_GetError());
+        return false;
+    }
+    // Empty cells are transparent over the background.
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+
+    layer.texture = tex;
+    layer.cols = cols;
+    layer.rows = rows;
+    layer.valid = false;
+    return true;
+}
+
+void destroyStaticLayer(StaticLayer &layer)
+{
+    if (layer.texture) {
+        SDL_DestroyTexture(layer.texture);
+        layer.texture = nullptr;
+    }
+    layer.valid = false;
+}
+
+// Bring the layer texture up to date with the grid: punch out cells that
+// emptied, draw cells that filled or changed type.
+static void updateStaticLayer(SDL_Renderer *renderer, TileAtlas &atlas, StaticLayer &layer,
+                              const Grid &grid)
+{
+    if (!layer.valid)
+        for (int r = 0; r < grid.height; ++r) layer.drawnRows[r] = 0;
+
+    RowMask removed[MAX_ROWS], added[MAX_ROWS];
+    int addCount = 0;
+    bool any = false;
+    for (int r = 0; r < grid.height; ++r) {
+        RowMask was = layer.drawnRows[r], now = grid.rows[r];
+        RowMask changed = was ^ now;
+        RowMask both = was & now;
+        // Types under empty cells are stale, so only compare where both
+        // have a tile, and only when the row differs at all.
+        if (both && std::memcmp(layer.drawnTypes[r], grid.types[r], (std::size_t)grid.width) != 0)
+            for (RowMask m = both; m; m &= m - 1) {
+                int c = ctz64(m);
+                if (layer.drawnTypes[r][c] != grid.types[r][c]) changed |= (RowMask)1u << c;
+            }
+        removed[r] = changed & ~now;
+        added[r]   = changed & now;
+        addCount  += popcount64(added[r]);
+        any = any || changed;
+    }
+    if (!any && layer.valid) return;
+
+    SDL_Texture *prevTarget = SDL_GetRenderTarget(renderer);
+    if (SDL_SetRenderTarget(renderer, layer.texture) != 0) {
+        layer.valid = false;
+        return;
+    }
+    SDL_BlendMode prevBlend;
+    SDL_GetRenderDrawBlendMode(renderer, &prevBlend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(renderer, 0,0,0,0);
+    if (!layer.valid) SDL_RenderClear(renderer);
+
+    // One transparent rect per run of emptied cells.
+    layer.holes.clear();
+    for (int r = 0; r < grid.height; ++r)
+        for (RowMask m = removed[r]; m; ) {
+            int c0 = ctz64(m);
+            RowMask run = ~(m >> c0);
+            int len = run ? ctz64(run) : 64 - c0;
+            m &= ~colRangeMask(c0, c0 + len - 1);
+            layer.holes.push_back(SDL_Rect{ c0 * CELL, r * CELL, len * CELL, CELL });
+        }
+    if (!layer.holes.empty())
+        SDL_RenderFillRects(renderer, layer.holes.data(), (int)layer.holes.size());
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    reserveQuads(atlas, addCount);
+#endif
+    atlas.verts.clear();
+    for (int r = 0; r < grid.height; ++r) addStaticCells(renderer, atlas, grid, r, added[r]);
+    flushQuads(renderer, atlas);
+
+    for (int r = 0; r < grid.height; ++r) {
+        layer.drawnRows[r] = grid.rows[r];
+        std::memcpy(layer.drawnTypes[r], grid.types[r], (std::size_t)grid.width);
+    }
+    layer.valid = true;
+
+    SDL_SetRenderDrawBlendMode(renderer, prevBlend);
+    SDL_SetRenderTarget(renderer, prevTarget);
+}
+
+void drawBoard(SDL_Renderer *renderer, TileAtlas &atlas, StaticLayer &layer,
+               const GameState &st, float alpha)
+{
+    const Grid &grid = st.grid;
+    const ShapePool &pool = st.shapes;
+
+    if (!atlas.texture) {
+        for (int row = 0; row < grid.height; ++row)
+            for (int col = 0; col < grid.width; ++col)
+                if (grid.occupied(col, row))
+                    drawTile(renderer, SDL_Rect{ col * CELL, row * CELL, CELL, CELL },
+                             grid.typeAt(col, row), false);
+        for (int k = 0; k < pool.shapeCount; ++k) {
+            const FallingShape &s = pool.shapes[k];
+            for (int i = s.first; i < s.first + s.count; ++i)
+                drawTile(renderer, SDL_Rect{ (int)(s.x + cellDx(pool.cells[i]) * CELL),
+                                             (int)(shapeY(s, alpha) + cellDy(pool.cells[i]) * CELL),
+                                             CELL, CELL },
+                         cellType(pool.cells[i]), true);
+        }
+        return;
+    }
+
+    bool cached = layer.texture && layer.cols == grid.width && layer.rows == grid.height;
+    if (cached) {
+        updateStaticLayer(renderer, atlas, layer, grid);
+        SDL_Rect dst{ 0, 0, grid.pixelWidth(), grid.pixelHeight() };
+        SDL_RenderCopy(renderer, layer.texture, nullptr, &dst);
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    reserveQuads(atlas, (cached ? 0 : grid.count) + pool.cellCount);
+#endif
+    atlas.verts.clear();
+    if (!cached)
+        for (int row = 0; row < grid.height; ++row)
+            addStaticCells(renderer, atlas, grid, row, grid.rows[row]);
+    addFallingCells(renderer, atlas, pool, alpha);
+    flushQuads(renderer, atlas);
+}
+
+void drawSpawnPreview(SDL_Renderer *renderer, const GameState &st)
+{
+    const SpawnSpec *next = nextSpawn(st);
+    if (!next || st.gameOver) return;
+
+    SDL_BlendMode prevBlend;
+    SDL_GetRenderDrawBlendMode(renderer, &prevBlend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 70);
+    for (int dy = 0; dy < next->h; ++dy)
+        for (int dx = 0; dx < next->w; ++dx) {
+            SDL_Rect r{ (next->col + dx) * CELL + 2, dy * CELL + 2, CELL - 4, CELL - 4 };
+            SDL_RenderDrawRect(renderer, &r);
+        }
+    SDL_SetRenderDrawBlendMode(renderer, prevBlend);
+}
+
+RenderBackend defaultRenderBackend(SDL_Renderer *renderer)
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_SOFTWARE))
+        return RENDER_FRAMEBUFFER;
+    return RENDER_TEXTURED;
+}
+
+bool createBoardView(SDL_Renderer *renderer, RenderBackend backend, int cols, int rows,
+                     BoardView &view)
+{
+    destroyBoardView(view);
+    view.cols = cols;
+    view.rows = rows;
+    view.backend = backend;
+    if (backend == RENDER_FRAMEBUFFER) {
+        view.frame = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                       SDL_TEXTUREACCESS_STREAMING,
+                                       cols * CELL, rows * CELL);
+        if (view.frame) return true;
+        SDL_Log("Framebuffer unavailable, drawing textured: %s", SDL_GetError());
+        view.backend = RENDER_TEXTURED;
+    }
+    return createStaticLayer(renderer, cols, rows, view.layer);
+}
+
+void destroyBoardView(BoardView &view)
+{
+    destroyStaticLayer(view.layer);
+    if (view.frame) {
+        SDL_DestroyTexture(view.frame);
+        view.frame = nullptr;
+    }
+}
+
+void drawPlayfield(SDL_Renderer *renderer, TileAtlas &atlas, BoardView &view,
+                   const GameState &st, float alpha)
+{
+    if (view.backend == RENDER_FRAMEBUFFER && view.frame &&
+        view.cols == st.grid.width && view.rows == st.grid.height) {
+        void *pixels;
+        int pitch;
+        if (SDL_LockTexture(view.frame, nullptr, &pixels, &pitch) == 0) {
+            Framebuffer fb{ static_cast<std::uint32_t *>(pixels),
+                            st.grid.pixelWidth(), st.grid.pixelHeight(),
+                            pitch / (int)sizeof(std::uint32_t) };
+            drawPlayfieldPixels(fb, st, alpha);
+            SDL_UnlockTexture(view.frame);
+            SDL_Rect dst{ 0, 0, fb.width, fb.height };
+            SDL_RenderCopy(renderer, view.frame, nullptr, &dst);
+            return;
+        }
+    }
+
+    drawBoard(renderer, atlas, view.layer, st, alpha);
+    drawSpawnPreview(renderer, st);
+
+    SDL_Rect playerRect{
+        st.prevPlayerX + (int)std::lround((st.player.x - st.prevPlayerX) * alpha),
+        st.prevPlayerY + (int)std::lround((st.player.y - st.prevPlayerY) * alpha),
+        st.player.w, st.player.h
+    };
+    SDL_SetRenderDrawColor(renderer, PLAYER_COLOR.r, PLAYER_COLOR.g, PLAYER_COLOR.b, 255);
+    SDL_RenderFillRect(renderer, &playerRect);
+}
+
+bool createTimerText(SDL_Renderer *renderer, TTF_Font *font, TimerText &text)
+{
+    destroyTimerText(text);
+    if (!font) return false;
+
+    static const char LABEL[] = "Time: ";
+    static const char STRIP[] = "Time: 0123456789.";
+    const int labelLen = (int)sizeof(LABEL) - 1;
+
+    SDL_Color white{255,255,255,255};
+    SDL_Surface *surf = TTF_RenderText_Blended(font, STRIP, white);
+    if (!surf) return false;
+    text.texture = SDL_CreateTextureFromSurface(renderer, surf);
+    int h = surf->h;
+    SDL_FreeSurface(surf);
+    if (!text.texture) return false;
+
+    // Glyph boundaries are the widths of successive prefixes of the strip.
+    char prefix[sizeof(STRIP)];
+    int prevX = 0;
+    for (int i = 1; i <= labelLen + TimerText::GLYPHS; ++i) {
+        std::snprintf(prefix, sizeof(prefix), "%.*s", i, STRIP);
+        int w = 0;
+        TTF_SizeText(font, prefix, &w, nullptr);
+        if (i == labelLen)
+            text.label = SDL_Rect{ 0, 0, w, h };
+        else if (i > labelLen)
+            text.glyph[i - labelLen - 1] = SDL_Rect{ prevX, 0, w - prevX, h };
+        prevX = w;
+    }
+    return true;
+}
+
+void destroyTimerText(TimerText &text)
+{
+    if (text.texture) {
+        SDL_DestroyTexture(text.texture);
+        text.texture = nullptr;
+    }
+}
+
+void drawTimerText(SDL_Renderer *renderer, const TimerText &text,
+                   int x, int y, float seconds)
+{
+    if (!text.texture) return;
+
+    SDL_Rect dst{ x, y, text.label.w, text.label.h };
+    SDL_RenderCopy(renderer, text.texture, &text.label, &dst);
+    dst.x += text.label.w;
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", seconds);
+    for (const char *p = buf; *p; ++p) {
+        int g = (*p == '.') ? 10 : (*p >= '0' && *p <= '9') ? (*p - '0') : -1;
+        if (g < 0) continue;
+        const SDL_Rect &src = text.glyph[g];
+        dst.w = src.w;
+        dst.h = src.h;
+        SDL_RenderCopy(renderer, text.texture, &src, &dst);
+        dst.x += src.w;
+    }
+}
+
+bool setOverlayText(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                    Uint32 wrapWidth, OverlayText &overlay)
+{
+    overlay.rect.w = overlay.rect.h = 0;
+    if (!font) return false;
+
+    SDL_Color white{255,255,255,255};
+    SDL_Surface *surf = wrapWidth ? TTF_RenderText_Blended_Wrapped(font, text, white, wrapWidth)
+                                  : TTF_RenderText_Blended(font, text, white);
+    if (!surf) return false;
+
+    if (!overlay.texture || surf->w > overlay.capW || surf->h > overlay.capH ||
+        surf->format->format != overlay.format) {
+        destroyOverlayText(overlay);
+        overlay.texture = SDL_CreateTexture(renderer, surf->format->format,
+                                            SDL_TEXTUREACCESS_STREAMING, surf->w, surf->h);
+        if (!overlay.texture) {
+            SDL_FreeSurface(surf);
+            return false;
+        }
+        SDL_SetTextureBlendMode(overlay.texture, SDL_BLENDMODE_BLEND);
+        overlay.format = surf->format->format;
+        overlay.capW = surf->w;
+        overlay.capH = surf->h;
+    }
+
+    SDL_Rect area{ 0, 0, surf->w, surf->h };
+    bool ok = SDL_UpdateTexture(overlay.texture, &area, surf->pixels, surf->pitch) == 0;
+    if (ok) {
+        overlay.rect.w = surf->w;
+        overlay.rect.h = surf->h;
+    }
+    SDL_FreeSurface(surf);
+    return ok;
+}
+
+void drawOverlayText(SDL_Renderer *renderer, const OverlayText &overlay)
+{
+    if (!overlay.texture || overlay.rect.w == 0) return;
+    SDL_Rect src{ 0, 0, overlay.rect.w, overlay.rect.h };
+    SDL_RenderCopy(renderer, overlay.texture, &src, &overlay.rect);
+}
+
+void destroyOverlayText(OverlayText &overlay)
+{
+    if (overlay.texture) {
+        SDL_DestroyTexture(overlay.texture);
+        overlay.texture = nullptr;
+    }
+    overlay.capW = overlay.capH = 0;
+    overlay.rect.w = overlay.rect.h = 0;
+}
+
+void updateProfilerOverlay(SDL_Renderer *renderer, TTF_Font *font,
+                           const Profiler &prof, ProfilerOverlay &overlay)
+{
+    Uint32 now = SDL_GetTicks();
+    if (overlay.texture && now - overlay.updatedAt < 250) return;
+    overlay.updatedAt = now;
+    if (!font) return;
+
+    char line[96];
+    std::snprintf(line, sizeof(line), "frame %6.2f ms%s\n%-10s %7s %7s",
+                  prof.frameAvgUs() / 1000.0, prof.capturing() ? "  [capturing]" : "",
+                  "us", "avg", "p99");
+    std::string text = line;
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        PhaseStats s = prof.stats((ProfPhase)p);
+        std::snprintf(line, sizeof(line), "\n%-10s %7.1f %7.1f",
+                      phaseName((ProfPhase)p), s.avgUs, s.p99Us);
+        text += line;
+    }
+
+    SDL_Color white{255,255,255,255};
+    SDL_Surface *surf = TTF_RenderText_Blended_Wrapped(font, text.c_str(), white, 400);
+    if (!surf) return;
+    SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surf);
+    int w = surf->w, h = surf->h;
+    SDL_FreeSurface(surf);
+    if (!tex) return;
+
+    destroyProfilerOverlay(overlay);
+    overlay.texture = tex;
+    overlay.rect = SDL_Rect{ 10, 40, w, h };   // under the timer
+}
+
+void drawProfilerOverlay(SDL_Renderer *renderer, const ProfilerOverlay &overlay)
+{
+    if (!overlay.texture) return;
+    SDL_Rect back{ overlay.rect.x - 4, overlay.rect.y - 4,
+                   overlay.rect.w + 8, overlay.rect.h + 8 };
+    SDL_SetRenderDrawColor(renderer, 0,0,0,180);
+    SDL_RenderFillRect(renderer, &back);
+    SDL_RenderCopy(renderer, overlay.texture, nullptr, &overlay.rect);
+}
+
+void destroyProfilerOverlay(ProfilerOverlay &overlay)
+{
+    if (overlay.texture) {
+        SDL_DestroyTexture(overlay.texture);
+        overlay.texture = nullptr;
+    }
+}
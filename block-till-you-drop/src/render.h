@@ -0,0 +1,130 @@
+#pragma once
+
+// Board rendering for the SDL frontend.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <vector>
+
+#include "framebuffer.h"
+#include "game.h"
+#include "profiler.h"
+
+// Every BlockType pre-drawn in its static and falling colours, side by side
+// in one texture, so the whole board goes out as a single textured batch.
+struct TileAtlas {
+    SDL_Texture *texture = nullptr;
+    std::vector<SDL_Vertex> verts;     // per-frame scratch, capacity kept
+    std::vector<int> indices;          // two triangles per quad, grown as needed
+};
+
+// Bake the atlas. On failure (e.g. no render-target support) the atlas
+// stays empty and drawBoard() falls back to drawing rects directly.
+bool createTileAtlas(SDL_Renderer *renderer, TileAtlas &atlas);
+void destroyTileAtlas(TileAtlas &atlas);
+
+// The static stack, retained in a board-sized target texture. Each frame
+// only the cells that differ from what was last drawn into it are redrawn,
+// so a quiet frame costs one copy however tall the stack is.
+struct StaticLayer {
+    SDL_Texture *texture = nullptr;
+    int  cols = 0, rows = 0;                            // board it was made for
+    bool valid = false;                                 // drawn* match the texture
+    RowMask      drawnRows[MAX_ROWS];
+    std::uint8_t drawnTypes[MAX_ROWS][MAX_COLS];
+    std::vector<SDL_Rect> holes;                        // per-update scratch
+};
+
+// Create the layer for a cols x rows board; also the way to recover from a
+// render-target or device reset. On failure drawBoard() draws the stack
+// every frame instead.
+bool createStaticLayer(SDL_Renderer *renderer, int cols, int rows, StaticLayer &layer);
+void destroyStaticLayer(StaticLayer &layer);
+
+// Draw the static stack and the falling shapes, the latter placed `alpha`
+// of the way from their previous tick's position to their current one.
+void drawBoard(SDL_Renderer *renderer, TileAtlas &atlas, StaticLayer &layer,
+               const GameState &st, float alpha);
+
+// Outline of the next shape to spawn, over the top rows at the column it
+// will drop in.
+void drawSpawnPreview(SDL_Renderer *renderer, const GameState &st);
+
+// How a playfield reaches the screen. TEXTURED draws through the atlas and
+// the static layer above. FRAMEBUFFER rasterizes the whole playfield in
+// software into a streaming texture and copies that out once: the better
+// choice when SDL is itself rendering in software, where every small
+// rect costs a draw call.
+enum RenderBackend {
+    RENDER_TEXTURED,
+    RENDER_FRAMEBUFFER
+};
+
+// FRAMEBUFFER if the renderer is SDL's software one, else TEXTURED.
+RenderBackend defaultRenderBackend(SDL_Renderer *renderer);
+
+// One playfield on screen, under either backend.
+struct BoardView {
+    RenderBackend backend = RENDER_TEXTURED;
+    StaticLayer   layer;                       // TEXTURED
+    SDL_Texture  *frame = nullptr;             // FRAMEBUFFER: streaming, board-sized
+    int cols = 0, rows = 0;
+};
+
+// Create the view for a cols x rows board; also the way to recover from a
+// render-target or device reset. If the streaming texture can't be made it
+// falls back to TEXTURED.
+bool createBoardView(SDL_Renderer *renderer, RenderBackend backend, int cols, int rows,
+                     BoardView &view);
+void destroyBoardView(BoardView &view);
+
+// Board, next-spawn outline and player, with the board's top-left at the
+// viewport origin.
+void drawPlayfield(SDL_Renderer *renderer, TileAtlas &atlas, BoardView &view,
+                   const GameState &st, float alpha);
+
+// HUD timer drawn from one pre-rasterized strip "Time: 0123456789.", so a
+// frame costs a handful of blits instead of a TTF render and texture upload.
+struct TimerText {
+    static const int GLYPHS = 11;          // '0'..'9', '.'
+    SDL_Texture *texture = nullptr;
+    SDL_Rect label{};                      // "Time: " within the strip
+    SDL_Rect glyph[GLYPHS]{};
+};
+
+bool createTimerText(SDL_Renderer *renderer, TTF_Font *font, TimerText &text);
+void destroyTimerText(TimerText &text);
+
+// Draw "Time: <seconds to one decimal>" with its top-left at (x, y).
+void drawTimerText(SDL_Renderer *renderer, const TimerText &text,
+                   int x, int y, float seconds);
+
+// A line or block of text kept in one streaming texture that is rewritten
+// in place; it is only reallocated when new text outgrows it. For overlay
+// text that changes once a game, e.g. the final time and high scores.
+struct OverlayText {
+    SDL_Texture *texture = nullptr;
+    Uint32 format = 0;
+    int capW = 0, capH = 0;
+    SDL_Rect rect{};                   // size of the current text; caller places x, y
+};
+
+// Rasterize `text` (wrapped at wrapWidth pixels, or one line if 0) into
+// the overlay's texture. On failure the overlay shows nothing.
+bool setOverlayText(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                    Uint32 wrapWidth, OverlayText &overlay);
+void drawOverlayText(SDL_Renderer *renderer, const OverlayText &overlay);
+void destroyOverlayText(OverlayText &overlay);
+
+// Profiler readout (per-phase rolling average and p99), re-rasterized a few
+// times a second rather than every frame.
+struct ProfilerOverlay {
+    SDL_Texture *texture = nullptr;
+    SDL_Rect rect{};
+    Uint32 updatedAt = 0;
+};
+
+void updateProfilerOverlay(SDL_Renderer *renderer, TTF_Font *font,
+                           const Profiler &prof, ProfilerOverlay &overlay);
+void drawProfilerOverlay(SDL_Renderer *renderer, const ProfilerOverlay &overlay);
+void destroyProfilerOverlay(ProfilerOverlay &overlay);
@@ -0,0 +1,250 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+static const char          REPLAY_MAGIC[4] = { 'B', 'T', 'Y', 'D' };
+static const std::uint16_t REPLAY_VERSION  = 3;
+
+// Serialized GameConfig fields, in file order. Version 1 had no board size.
+static float GameConfig::*const CONFIG_FLOATS[] = {
+    &GameConfig::playerSpeed, &GameConfig::gravity, &GameConfig::jumpV,
+    &GameConfig::abilityCd, &GameConfig::spawnInterval, &GameConfig::baseFall,
+    &GameConfig::maxExtra, &GameConfig::powerupMaxGap, &GameConfig::freezeDuration
+};
+static_assert(sizeof(GameConfig) == sizeof(CONFIG_FLOATS) / sizeof(CONFIG_FLOATS[0]) * sizeof(float)
+                                    + 2 * sizeof(int),
+              "GameConfig changed: update the replay header and REPLAY_VERSION");
+
+void Replay::begin(std::uint64_t gameSeed, const GameConfig &cfg)
+{
+    seed   = gameSeed;
+    config = cfg;
+    ticks  = 0;
+    runs.clear();
+    legacySpawns = false;
+}
+
+void Replay::record(InputMask input)
+{
+    if (!runs.empty() && runs.back().input == input)
+        ++runs.back().length;
+    else
+        runs.push_back(ReplayRun{ 1, input });
+    ++ticks;
+}
+
+// ---- Serialization ----
+
+static void putU16(std::vector<std::uint8_t> &out, std::uint16_t v)
+{
+    out.push_back((std::uint8_t)v);
+    out.push_back((std::uint8_t)(v >> 8));
+}
+
+static void putU32(std::vector<std::uint8_t> &out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back((std::uint8_t)(v >> (8 * i)));
+}
+
+static void putU64(std::vector<std::uint8_t> &out, std::uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out.push_back((std::uint8_t)(v >> (8 * i)));
+}
+
+static void putVarint(std::vector<std::uint8_t> &out, std::uint32_t v)
+{
+    while (v >= 0x80) {
+        out.push_back((std::uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((std::uint8_t)v);
+}
+
+// Bounds-checked little-endian reader over a loaded file.
+struct ByteReader {
+    const std::uint8_t *p, *end;
+
+    bool u8(std::uint8_t &v) {
+        if (p >= end) return false;
+        v = *p++;
+        return true;
+    }
+    bool u16(std::uint16_t &v) {
+        if (end - p < 2) return false;
+        v = (std::uint16_t)(p[0] | (p[1] << 8));
+        p += 2;
+        return true;
+    }
+    bool u32(std::uint32_t &v) {
+        if (end - p < 4) return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i) v |= (std::uint32_t)p[i] << (8 * i);
+        p += 4;
+        return true;
+    }
+    bool u64(std::uint64_t &v) {
+        if (end - p < 8) return false;
+        v = 0;
+        for (int i = 0; i < 8; ++i) v |= (std::uint64_t)p[i] << (8 * i);
+        p += 8;
+        return true;
+    }
+    bool varint(std::uint32_t &v) {
+        v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            std::uint8_t b;
+            if (!u8(b)) return false;
+            v |= (std::uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+bool saveReplay(const char *path, const Replay &replay)
+{
+    std::vector<std::uint8_t> out;
+    out.reserve(64 + replay.runs.size() * 3);
+
+    out.insert(out.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+    putU16(out, REPLAY_VERSION);
+    putU16(out, (std::uint16_t)TICK_RATE);
+    putU64(out, replay.seed);
+
+    putU16(out, (std::uint16_t)replay.config.cols);
+    putU16(out, (std::uint16_t)replay.config.rows);
+    for (float GameConfig::*field : CONFIG_FLOATS) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &(replay.config.*field), sizeof(bits));
+        putU32(out, bits);
+    }
+
+    putU32(out, replay.ticks);
+    putU32(out, (std::uint32_t)replay.runs.size());
+    for (const ReplayRun &r : replay.runs) {
+        putVarint(out, r.length);
+        out.push_back(r.input);
+    }
+
+    std::FILE *f = std::fopen(path, "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (std::fclose(f) == 0) && ok;
+    return ok;
+}
+
+bool loadReplay(const char *path, Replay &replay)
+{
+    std::FILE *f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::vector<std::uint8_t> data;
+    std::uint8_t chunk[4096];
+    for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), f)) > 0; )
+        data.insert(data.end(), chunk, chunk + n);
+    std::fclose(f);
+
+    ByteReader in{ data.data(), data.data() + data.size() };
+    if (data.size() < 4 || std::memcmp(in.p, REPLAY_MAGIC, 4) != 0) return false;
+    in.p += 4;
+
+    std::uint16_t version, tickRate;
+    if (!in.u16(version) || version < 1 || version > REPLAY_VERSION) return false;
+    // Inputs were sampled per tick; another tick rate is another game.
+    if (!in.u16(tickRate) || tickRate != TICK_RATE) return false;
+
+    Replay r;
+    r.legacySpawns = version < 3;
+    if (!in.u64(r.seed)) return false;
+    if (version >= 2) {
+        std::uint16_t cols, rows;
+        if (!in.u16(cols) || !in.u16(rows)) return false;
+        r.config.cols = cols;
+        r.config.rows = rows;
+    }
+    for (float GameConfig::*field : CONFIG_FLOATS) {
+        std::uint32_t bits;
+        if (!in.u32(bits)) return false;
+        std::memcpy(&(r.config.*field), &bits, sizeof(bits));
+    }
+
+    std::uint32_t runCount;
+    if (!in.u32(r.ticks) || !in.u32(runCount)) return false;
+    if (runCount > (std::uint32_t)(in.end - in.p) / 2) return false;
+    r.runs.resize(runCount);
+
+    // Runs are never empty and cover `ticks` exactly; anything else is a
+    // damaged file, not a game.
+    std::uint64_t total = 0;
+    for (ReplayRun &run : r.runs) {
+        if (!in.varint(run.length) || run.length == 0 || !in.u8(run.input)) return false;
+        total += run.length;
+    }
+    if (total != r.ticks) return false;
+
+    replay = std::move(r);
+    return true;
+}
+
+// ---- Playback ----
+
+ReplayPlayer::ReplayPlayer(const Replay &replay_) : replay(replay_)
+{
+    restart();
+}
+
+void ReplayPlayer::restart()
+{
+    st.config = replay.config;
+    st.legacySpawns = replay.legacySpawns;
+    resetGame(st, replay.seed);
+    run = inRun = 0;
+    if (snapshots.empty())
+        snapshots.push_back(Snapshot{ st, run, inRun });
+}
+
+InputMask ReplayPlayer::currentInput() const
+{
+    return run < replay.runs.size() ? replay.runs[run].input : (InputMask)0;
+}
+
+bool ReplayPlayer::stepOnce()
+{
+    if (done()) return false;
+
+    InputMask input = currentInput();
+    if (++inRun >= replay.runs[run].length) {
+        ++run;
+        inRun = 0;
+    }
+    bool ended = step(st, input, TICK_DT);
+
+    if (st.tick % SNAPSHOT_INTERVAL == 0 &&
+        st.tick / SNAPSHOT_INTERVAL == snapshots.size())
+        snapshots.push_back(Snapshot{ st, run, inRun });
+    return ended;
+}
+
+void ReplayPlayer::runToEnd()
+{
+    while (!done()) stepOnce();
+}
+
+void ReplayPlayer::seek(std::uint32_t tick)
+{
+    if (tick > replay.ticks) tick = replay.ticks;
+
+    // Restore the latest snapshot at or before the target unless we are
+    // already between it and the target.
+    std::size_t k = std::min<std::size_t>(tick / SNAPSHOT_INTERVAL, snapshots.size() - 1);
+    std::uint32_t snapTick = (std::uint32_t)k * SNAPSHOT_INTERVAL;
+    if (st.tick > tick || st.tick < snapTick) {
+        const Snapshot &s = snapshots[k];
+        copyGameState(st, s.state);
+        run   = s.run;
+        inRun = s.inRun;
+    }
+    while (st.tick < tick && !done()) stepOnce();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Input recording and deterministic playback.
+//
+// A replay is the game's seed and config plus the InputMask of every tick,
+// run-length encoded. Because the simulation only advances in fixed ticks
+// from its own Rng, replaying those inputs reproduces the game exactly.
+//
+// File layout (little-endian):
+//   "BTYD"  magic
+//   u16     format version
+//   u16     tick rate the replay was recorded at
+//   u64     seed
+//   u16 x2  board columns, rows (version 2+; version 1 replays are 16x20)
+//   f32 x9  GameConfig tunables, in declaration order
+//   u32     total ticks
+//   u32     run count
+//   runs:   LEB128 run length (at least 1), then u8 input mask
+//
+// Versions 1 and 2 predate the spawn queue; they play back with
+// GameState::legacySpawns set.
+
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+
+struct ReplayRun {
+    std::uint32_t length;
+    InputMask     input;
+};
+
+struct Replay {
+    std::uint64_t seed = 0;
+    GameConfig    config;
+    std::uint32_t ticks = 0;
+    std::vector<ReplayRun> runs;
+    bool          legacySpawns = false;  // loaded from a version 1 or 2 file
+
+    void begin(std::uint64_t gameSeed, const GameConfig &cfg);
+    void record(InputMask input);     // append one tick
+};
+
+bool saveReplay(const char *path, const Replay &replay);
+bool loadReplay(const char *path, Replay &replay);
+
+// Plays a replay through the engine. A copy of the whole GameState is kept
+// every SNAPSHOT_INTERVAL ticks as playback first passes it, so seeking
+// re-simulates from the nearest snapshot rather than from tick 0.
+class ReplayPlayer {
+public:
+    static const std::uint32_t SNAPSHOT_INTERVAL = 5 * TICK_RATE;
+
+    explicit ReplayPlayer(const Replay &replay);
+
+    void restart();
+    bool done() const { return st.gameOver || st.tick >= replay.ticks; }
+
+    // Advance one tick; returns true on the tick the game ends.
+    bool stepOnce();
+    void runToEnd();
+    void seek(std::uint32_t tick);
+
+    InputMask currentInput() const;
+    const GameState &state() const { return st; }
+
+private:
+    struct Snapshot {
+        GameState     state;
+        std::uint32_t run, inRun;
+    };
+
+    const Replay &replay;
+    GameState     st;
+    std::uint32_t run = 0, inRun = 0;   // cursor into replay.runs
+    std::vector<Snapshot> snapshots;  // snapshots[i] is at tick i * interval
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+// Small seeded PRNG (PCG32). Plain data, so it copies along with the game
+// state and every game can own its own stream.
+
+#include <cstdint>
+
+struct Rng {
+    std::uint64_t state;
+    std::uint64_t inc;
+
+    void seed(std::uint64_t s, std::uint64_t stream = 0x14057b7ef767814fULL) {
+        state = 0;
+        inc   = (stream << 1) | 1u;
+        next();
+        state += s;
+        next();
+    }
+
+    std::uint32_t next() {
+        std::uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        std::uint32_t xorshifted = (std::uint32_t)(((old >> 18u) ^ old) >> 27u);
+        std::uint32_t rot = (std::uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Uniform in [0, n) for n > 0.
+    int below(int n) {
+        return (int)(((std::uint64_t)next() * (std::uint32_t)n) >> 32);
+    }
+};
+
+// Spreads consecutive integers into well-mixed seeds (splitmix64).
+inline std::uint64_t mixSeed(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
@@ -0,0 +1,143 @@
+#include "scores.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char          SCORES_MAGIC[4] = { 'B', 'T', 'H', 'S' };
+static const std::uint16_t SCORES_VERSION  = 1;
+static const std::size_t   HEADER_SIZE     = 8;
+static const std::size_t   RECORD_SIZE     = 4 + 8 + 2 + 2 + sizeof(ScoreEntry::player);
+
+static void putLE(std::uint8_t *out, std::uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) out[i] = (std::uint8_t)(v >> (8 * i));
+}
+
+static std::uint64_t getLE(const std::uint8_t *in, int bytes)
+{
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= (std::uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+static void encodeEntry(const ScoreEntry &e, std::uint8_t *out)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &e.time, sizeof(bits));
+    putLE(out, bits, 4);
+    putLE(out + 4, e.when, 8);
+    putLE(out + 12, e.cols, 2);
+    putLE(out + 14, e.rows, 2);
+    std::memcpy(out + 16, e.player, sizeof(e.player));
+}
+
+static void decodeEntry(const std::uint8_t *in, ScoreEntry &e)
+{
+    std::uint32_t bits = (std::uint32_t)getLE(in, 4);
+    std::memcpy(&e.time, &bits, sizeof(bits));
+    e.when = getLE(in + 4, 8);
+    e.cols = (std::uint16_t)getLE(in + 12, 2);
+    e.rows = (std::uint16_t)getLE(in + 14, 2);
+    std::memcpy(e.player, in + 16, sizeof(e.player));
+    e.player[sizeof(e.player) - 1] = '\0';
+}
+
+// Heap order: the worst kept score at the front.
+static bool betterScore(const ScoreEntry &a, const ScoreEntry &b)
+{
+    return a.time > b.time;
+}
+
+void HighScores::keep(const ScoreEntry &entry)
+{
+    if ((int)top.size() < TOP_N) {
+        top.push_back(entry);
+        std::push_heap(top.begin(), top.end(), betterScore);
+    } else if (betterScore(entry, top.front())) {
+        std::pop_heap(top.begin(), top.end(), betterScore);
+        top.back() = entry;
+        std::push_heap(top.begin(), top.end(), betterScore);
+    }
+}
+
+bool HighScores::load(const char *path_, int cols_, int rows_)
+{
+    path = nullptr;
+    cols = cols_;
+    rows = rows_;
+    top.clear();
+
+    std::FILE *f = std::fopen(path_, "rb");
+    if (!f) {
+        path = path_;
+        return true;
+    }
+
+    std::uint8_t header[HEADER_SIZE];
+    std::size_t n = std::fread(header, 1, HEADER_SIZE, f);
+    if (n == 0) {
+        std::fclose(f);
+        path = path_;
+        return true;
+    }
+    if (n < HEADER_SIZE || std::memcmp(header, SCORES_MAGIC, 4) != 0 ||
+        getLE(header + 4, 2) != SCORES_VERSION || getLE(header + 6, 2) != RECORD_SIZE) {
+        std::fclose(f);
+        return false;
+    }
+
+    // Whole records per read; a trailing partial one never fills a slot.
+    std::uint8_t chunk[256 * RECORD_SIZE];
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) >= RECORD_SIZE) {
+        for (std::size_t at = 0; at + RECORD_SIZE <= n; at += RECORD_SIZE) {
+            ScoreEntry e;
+            decodeEntry(chunk + at, e);
+            if (e.cols == cols && e.rows == rows) keep(e);
+        }
+        if (n % RECORD_SIZE) break;
+    }
+    std::fclose(f);
+    path = path_;
+    return true;
+}
+
+bool HighScores::add(const ScoreEntry &entry)
+{
+    if (entry.cols == cols && entry.rows == rows) keep(entry);
+    if (!path) return false;
+
+    std::FILE *f = std::fopen(path, "ab");
+    if (!f) return false;
+    bool ok = true;
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    if (size < 0 || (size > 0 && size < (long)HEADER_SIZE)) {
+        std::fclose(f);
+        return false;
+    }
+    if (size == 0) {
+        std::uint8_t header[HEADER_SIZE];
+        std::memcpy(header, SCORES_MAGIC, 4);
+        putLE(header + 4, SCORES_VERSION, 2);
+        putLE(header + 6, RECORD_SIZE, 2);
+        ok = std::fwrite(header, 1, HEADER_SIZE, f) == HEADER_SIZE;
+    } else if (std::size_t pad = ((std::size_t)size - HEADER_SIZE) % RECORD_SIZE) {
+        // Finish a torn record with zeros so the new one lands on a record
+        // boundary. Its board size ends up 0 unless it was nearly whole.
+        static const std::uint8_t zeros[RECORD_SIZE] = {};
+        ok = std::fwrite(zeros, 1, RECORD_SIZE - pad, f) == RECORD_SIZE - pad;
+    }
+    std::uint8_t record[RECORD_SIZE];
+    encodeEntry(entry, record);
+    ok = ok && std::fwrite(record, 1, RECORD_SIZE, f) == RECORD_SIZE;
+    ok = (std::fclose(f) == 0) && ok;
+    return ok;
+}
+
+std::vector<ScoreEntry> HighScores::best() const
+{
+    std::vector<ScoreEntry> sorted = top;
+    std::sort_heap(sorted.begin(), sorted.end(), betterScore);
+    return sorted;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// Persistent high-score table.
+//
+// Every finished game is appended to one file as a fixed-size record, so
+// saving never rewrites the file and a cabinet can keep months of plays.
+// Loading streams the records through a bounded min-heap of the best TOP_N
+// for the current board; nothing else is kept in memory, and inserting a
+// new score is O(log TOP_N).
+//
+// File layout (little-endian):
+//   "BTHS"  magic
+//   u16     format version
+//   u16     record size in bytes
+//   records, each:
+//     f32   survival time in seconds
+//     u64   when, seconds since the Unix epoch
+//     u16   board columns
+//     u16   board rows
+//     char  player name [16], NUL-padded
+// A partial record at the end (from a crash mid-append) is ignored, and
+// padded out to a whole one by the next append.
+
+#include <cstdint>
+#include <vector>
+
+struct ScoreEntry {
+    float         time;
+    std::uint64_t when;
+    std::uint16_t cols, rows;
+    char          player[16];     // NUL-terminated
+};
+
+class HighScores {
+public:
+    static const int TOP_N = 5;
+
+    // Read the best scores on a cols x rows board from path. A missing
+    // file is an empty table. If the file is not a score file, returns false
+    // and later scores are only kept in memory, leaving the file alone.
+    bool load(const char *path, int cols, int rows);
+
+    // Append the entry to the file (creating it if needed) and keep it in
+    // the table if it makes the top on this board. False if it could not
+    // be written.
+    bool add(const ScoreEntry &entry);
+
+    // Best first.
+    std::vector<ScoreEntry> best() const;
+
+private:
+    void keep(const ScoreEntry &entry);
+
+    const char   *path = nullptr;
+    int           cols = 0, rows = 0;
+    std::vector<ScoreEntry> top;    // min-heap on time, at most TOP_N
+};
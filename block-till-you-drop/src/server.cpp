@@ -0,0 +1,424 @@
+#include "server.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+
+typedef std::chrono::steady_clock Clock;
+
+// Rounds a worker may spend catching its sessions up in one wake before it
+// reads its inbox again; a tenth of a second of play.
+static const int MAX_CATCHUP = TICK_RATE / 10;
+
+// A join cookie is good for the period it was made in and the next one.
+static const std::uint64_t COOKIE_PERIOD_NS = 16000000000ull;
+
+// Half-octave buckets: 2 per power of two, the second for values whose next
+// bit down is set.
+static int latencyBucket(std::uint64_t ns)
+{
+    if (ns < 2) return 0;
+    int b = msb64(ns);
+    return std::min(2 * b + (int)((ns >> (b - 1)) & 1u), LatencyStats::BUCKETS - 1);
+}
+
+void LatencyStats::add(std::uint64_t ns)
+{
+    double us = (double)ns / 1000.0;
+    ++count;
+    totalUs += us;
+    maxUs = std::max(maxUs, us);
+    ++buckets[latencyBucket(ns)];
+}
+
+void LatencyStats::merge(const LatencyStats &other)
+{
+    count += other.count;
+    totalUs += other.totalUs;
+    maxUs = std::max(maxUs, other.maxUs);
+    for (int b = 0; b < BUCKETS; ++b) buckets[b] += other.buckets[b];
+}
+
+double LatencyStats::percentileUs(double p) const
+{
+    if (count == 0) return 0.0;
+    std::uint64_t want = (std::uint64_t)(p * (double)count);
+    std::uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen > want) {
+            // Bucket b holds [2^k, 1.5 * 2^k) or [1.5 * 2^k, 2^(k+1)).
+            double top = (b & 1) ? 2.0 : 1.5;
+            return std::min(maxUs, top * (double)(1ull << (b / 2)) / 1000.0);
+        }
+    }
+    return maxUs;
+}
+
+TournamentServer::~TournamentServer()
+{
+    stop();
+}
+
+bool TournamentServer::start(const ServerConfig &config)
+{
+    if (running()) return false;
+    cfg = config;
+    cfg.workers = std::max(1, cfg.workers);
+    cfg.maxSessions = std::max(cfg.maxSessions, cfg.workers);
+    cfg.sendEveryTicks = std::max(1, cfg.sendEveryTicks);
+    clampBoardSize(cfg.game);
+    if (!socket.open(cfg.port)) return false;
+
+    epoch = Clock::now();
+    const std::uint64_t entropy = (std::uint64_t)epoch.time_since_epoch().count();
+    std::random_device device;
+    cookieSecret = mixSeed(((std::uint64_t)device() << 32) ^ device() ^ entropy);
+    const int perWorker = std::min((cfg.maxSessions + cfg.workers - 1) / cfg.workers,
+                                   MAX_WORKER_SESSIONS);
+    cfg.maxSessions = std::min(cfg.maxSessions, perWorker * cfg.workers);
+    workers.clear();
+    for (int w = 0; w < cfg.workers; ++w) {
+        std::unique_ptr<Worker> worker(new Worker);
+        worker->sessions.resize((std::size_t)perWorker);
+        worker->snapshot.reserve((std::size_t)perWorker);
+        worker->firstSlot = w * perWorker;
+        worker->seeds.seed(mixSeed(entropy + (std::uint64_t)w), 0x5e55);
+        workers.push_back(std::move(worker));
+    }
+
+    stopping.store(false);
+    live.store(0);
+    ticks.store(0);
+    waiting.store(0);
+    threads.emplace_back(&TournamentServer::receiveLoop, this);
+    for (int w = 0; w < cfg.workers; ++w)
+        threads.emplace_back(&TournamentServer::workerLoop, this, w);
+    return true;
+}
+
+void TournamentServer::stop()
+{
+    if (!running()) return;
+    stopping.store(true, std::memory_order_release);
+    for (std::thread &t : threads) t.join();
+    threads.clear();
+    socket.close();
+    workers.clear();
+    live.store(0);
+    waiting.store(0);
+}
+
+std::uint64_t TournamentServer::nowNs() const
+{
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - epoch).count();
+}
+
+// Server tick n is due once n + 1 tick lengths have passed since the epoch.
+static std::uint64_t tickDueNs(std::uint64_t tick)
+{
+    return (tick + 1) * 1000000000ull / TICK_RATE;
+}
+
+// Unguessable without the secret, and the same for a given address all
+// through a period, so a challenge needs no state.
+std::uint64_t TournamentServer::joinCookie(const NetAddress &from, std::uint64_t period) const
+{
+    std::uint64_t c = mixSeed(mixSeed(cookieSecret + period) ^ from.key());
+    return c ? c : 1;                   // 0 is the first hello's seed
+}
+
+// Owns the address -> slot map, the free slots and the per-IP counts;
+// workers hand slots back through their `closed` queues.
+void TournamentServer::receiveLoop()
+{
+    const int perWorker = (int)workers[0]->sessions.size();
+    const int slots = perWorker * (int)workers.size();
+    std::unordered_map<std::uint64_t, int> bySender;
+    bySender.reserve((std::size_t)slots * 2);
+    std::unordered_map<std::uint32_t, int> perIp;
+    perIp.reserve((std::size_t)slots * 2);
+    auto forget = [&](std::uint64_t sender) {
+        bySender.erase(sender);
+        auto ip = perIp.find((std::uint32_t)(sender >> 16));
+        if (ip != perIp.end() && --ip->second == 0) perIp.erase(ip);
+    };
+    std::vector<std::uint64_t> slotSender((std::size_t)slots, 0);
+    // Hand out one slot per worker in turn, so load spreads evenly.
+    std::vector<int> freeSlots;
+    freeSlots.reserve((std::size_t)slots);
+    for (int k = perWorker - 1; k >= 0; --k)
+        for (int w = (int)workers.size() - 1; w >= 0; --w) freeSlots.push_back(w * perWorker + k);
+
+    std::uint8_t buf[MAX_PACKET_SIZE];
+    Inbound in;
+    while (!stopping.load(std::memory_order_acquire)) {
+        for (auto &worker : workers) {
+            int slot;
+            while (worker->closed.tryPop(slot)) {
+                forget(slotSender[(std::size_t)slot]);
+                freeSlots.push_back(slot);
+            }
+        }
+
+        if (!socket.waitReadable(10)) continue;
+        int n;
+        while ((n = socket.receiveFrom(buf, sizeof(buf), in.from)) >= 0) {
+            if (!decodeInputPacket(buf, (std::size_t)n, in.packet)) continue;
+            auto found = bySender.find(in.from.key());
+            if (found != bySender.end()) {
+                in.slot = found->second;
+                in.join = false;
+            } else {
+                // Only a hello starts a session, so stray packets from a
+                // closed one don't open another.
+                const InputPacket &p = in.packet;
+                if (p.count != 0 || p.first != 0 || p.ack != 0) continue;
+                std::uint64_t period = nowNs() / COOKIE_PERIOD_NS;
+                if (p.seed == 0 || (p.seed != joinCookie(in.from, period) &&
+                                    (period == 0 || p.seed != joinCookie(in.from, period - 1)))) {
+                    InputPacket challenge = {};
+                    challenge.seed = joinCookie(in.from, period);
+                    std::size_t size = encodeInputPacket(challenge, buf);
+                    socket.sendTo(in.from, buf, size);
+                    continue;
+                }
+                int &fromIp = perIp[in.from.ip];
+                if (freeSlots.empty() || fromIp >= cfg.maxSessionsPerIp) {
+                    if (fromIp == 0) perIp.erase(in.from.ip);
+                    continue;
+                }
+                ++fromIp;
+                in.slot = freeSlots.back();
+                freeSlots.pop_back();
+                in.join = true;
+                bySender[in.from.key()] = in.slot;
+                slotSender[(std::size_t)in.slot] = in.from.key();
+            }
+            // A full inbox drops the packet; the client resends anyway.
+            if (!workers[(std::size_t)(in.slot / perWorker)]->inbox.tryPush(in) && in.join) {
+                forget(in.from.key());
+                freeSlots.push_back(in.slot);
+            }
+        }
+    }
+}
+
+void TournamentServer::workerLoop(int w)
+{
+    Worker &worker = *workers[(std::size_t)w];
+    const std::uint64_t idleTicks   = (std::uint64_t)cfg.idleTimeoutMs * TICK_RATE / 1000;
+    const std::uint64_t joinTicks   = (std::uint64_t)cfg.joinTimeoutMs * TICK_RATE / 1000;
+    const std::uint64_t publishEvery = TICK_RATE;
+    std::uint64_t nextPublish = 0;
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        // Ticks fully due by now.
+        const std::uint64_t serverTick = nowNs() * TICK_RATE / 1000000000ull;
+
+        Inbound in;
+        while (worker.inbox.tryPop(in)) handle(worker, in, serverTick);
+
+        // Every due session steps once per round, so one that fell far
+        // behind can't hold up the rest.
+        std::uint64_t stepped = 0;
+        for (int round = 0; round < MAX_CATCHUP; ++round) {
+            bool any = false;
+            for (Session &s : worker.sessions) {
+                if (s.phase != SESSION_PLAYING || s.startTick + s.state.tick >= serverTick) continue;
+                // Held: a further step would overwrite an applied input the
+                // client hasn't acked, and it could never rebuild the game.
+                if (s.state.tick - s.clientAck >= (std::uint32_t)INPUT_RING) continue;
+                tickSession(s);
+                ++stepped;
+                any = true;
+                if (s.state.gameOver) {
+                    s.phase = SESSION_LINGERING;
+                    s.endTick = serverTick + (std::uint64_t)cfg.lingerMs * TICK_RATE / 1000;
+                }
+            }
+            if (!any) break;
+        }
+        if (stepped) ticks.fetch_add(stepped, std::memory_order_relaxed);
+
+        for (int i = 0; i < (int)worker.sessions.size(); ++i) {
+            Session &s = worker.sessions[(std::size_t)i];
+            if (s.phase == SESSION_FREE) continue;
+            if (s.phase == SESSION_CLOSING) {
+                if (release(worker, i)) waiting.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (serverTick >= s.nextReplyTick) {
+                reply(s);
+                s.nextReplyTick = serverTick + (std::uint64_t)cfg.sendEveryTicks;
+            }
+            bool lost = serverTick - s.lastHeardTick > idleTicks ||
+                        (s.clientTicks == 0 && serverTick - s.startTick > joinTicks);
+            bool done = s.phase == SESSION_LINGERING &&
+                        (serverTick >= s.endTick || s.clientAck >= s.state.tick);
+            if (lost || done) close(worker, i, s.state.gameOver);
+        }
+
+        if (serverTick >= nextPublish) {
+            publish(worker);
+            nextPublish = serverTick + publishEvery;
+        }
+
+        std::this_thread::sleep_until(epoch + std::chrono::nanoseconds(tickDueNs(serverTick)));
+    }
+}
+
+void TournamentServer::handle(Worker &worker, const Inbound &in, std::uint64_t serverTick)
+{
+    Session &s = worker.sessions[(std::size_t)(in.slot - worker.firstSlot)];
+    const InputPacket &p = in.packet;
+
+    if (in.join) {
+        GameConfig game = cfg.game;
+        if (p.cols >= MIN_COLS && p.cols <= MAX_COLS && p.rows >= MIN_ROWS && p.rows <= MAX_ROWS) {
+            game.cols = p.cols;
+            game.rows = p.rows;
+        }
+        s.phase = SESSION_PLAYING;
+        s.client = in.from;
+        s.state.config = game;
+        s.state.legacySpawns = false;
+        s.seed = ((std::uint64_t)worker.seeds.next() << 32) | worker.seeds.next();
+        resetGame(s.state, s.seed);
+        s.startTick = serverTick;
+        s.clientTicks = s.clientAck = 0;
+        s.held = 0;
+        s.lastHeardTick = serverTick;
+        s.nextReplyTick = serverTick;       // answer the hello right away
+        s.lateInputs = s.heldInputs = 0;
+        s.step = LatencyStats();
+        s.latency = LatencyStats();
+        live.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (s.phase == SESSION_FREE || s.phase == SESSION_CLOSING) return;
+
+    s.lastHeardTick = serverTick;
+    s.clientAck = std::max(s.clientAck, std::min(p.ack, s.state.tick));
+
+    // Same rule as versus: ranges may overlap what is known, not leave a gap.
+    if (p.first > s.clientTicks) return;
+    std::uint32_t end = p.first + (std::uint32_t)p.count;
+    std::uint32_t limit = s.state.tick + (std::uint32_t)INPUT_RING;
+    for (std::uint32_t t = s.clientTicks; t < end && t < limit; ++t) {
+        if (t < s.state.tick) ++s.lateInputs;
+        else s.clientInput[t % INPUT_RING] = p.inputs[t - p.first];
+        s.clientTicks = t + 1;
+    }
+}
+
+void TournamentServer::tickSession(Session &s)
+{
+    const std::uint32_t t = s.state.tick;
+    InputMask input;
+    if (t < s.clientTicks) {
+        input = s.clientInput[t % INPUT_RING];
+    } else {
+        input = s.held;
+        ++s.heldInputs;
+    }
+    s.held = input;
+    s.applied[t % INPUT_RING] = input;
+
+    std::uint64_t begin = nowNs();
+    step(s.state, input, TICK_DT);
+    std::uint64_t done = nowNs();
+    s.step.add(done - begin);
+    std::uint64_t due = tickDueNs(s.startTick + t);
+    s.latency.add(done > due ? done - due : 0);
+}
+
+void TournamentServer::reply(Session &s)
+{
+    InputPacket p;
+    p.seed  = s.seed;
+    p.cols  = (std::uint16_t)s.state.config.cols;
+    p.rows  = (std::uint16_t)s.state.config.rows;
+    p.ack   = s.clientTicks;
+    p.first = s.clientAck;
+    p.count = (int)std::min<std::uint32_t>(s.state.tick - s.clientAck, InputPacket::MAX_INPUTS);
+    for (int k = 0; k < p.count; ++k) p.inputs[k] = s.applied[(p.first + (std::uint32_t)k) % INPUT_RING];
+
+    std::uint8_t buf[MAX_PACKET_SIZE];
+    std::size_t size = encodeInputPacket(p, buf);
+    socket.sendTo(s.client, buf, size);
+}
+
+void TournamentServer::close(Worker &worker, int index, bool finished)
+{
+    Session &s = worker.sessions[(std::size_t)index];
+    SessionResult &r = s.result;
+    r.client       = s.client;
+    r.seed         = s.seed;
+    r.cols         = (std::uint16_t)s.state.config.cols;
+    r.rows         = (std::uint16_t)s.state.config.rows;
+    r.survival     = s.state.elapsedTime;
+    r.rowsCleared  = s.state.stats.rowsCleared;
+    r.powerupsUsed = s.state.stats.powerupsUsed;
+    r.finished     = finished;
+    r.latencyP99Us = s.latency.percentileUs(0.99);
+
+    s.phase = SESSION_CLOSING;
+    live.fetch_sub(1, std::memory_order_relaxed);
+    if (!release(worker, index)) waiting.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Publish a closing session's result and hand its slot back; false, with
+// the session left as it is, while the results queue is full.
+bool TournamentServer::release(Worker &worker, int index)
+{
+    Session &s = worker.sessions[(std::size_t)index];
+    if (!worker.results.tryPush(s.result)) return false;
+    s.phase = SESSION_FREE;
+    // A slot is queued once per close and the queue holds the whole slab,
+    // so this cannot fail.
+    worker.closed.tryPush(worker.firstSlot + index);
+    return true;
+}
+
+void TournamentServer::publish(Worker &worker)
+{
+    std::lock_guard<std::mutex> lock(worker.published);
+    worker.snapshot.clear();
+    for (const Session &s : worker.sessions) {
+        if (s.phase == SESSION_FREE || s.phase == SESSION_CLOSING) continue;
+        SessionMetrics m;
+        m.client     = s.client;
+        m.seed       = s.seed;
+        m.tick       = s.state.tick;
+        m.gameOver   = s.state.gameOver;
+        m.lateInputs = s.lateInputs;
+        m.heldInputs = s.heldInputs;
+        m.step       = s.step;
+        m.latency    = s.latency;
+        worker.snapshot.push_back(m);
+    }
+}
+
+std::vector<SessionMetrics> TournamentServer::metrics()
+{
+    std::vector<SessionMetrics> all;
+    for (auto &worker : workers) {
+        std::lock_guard<std::mutex> lock(worker->published);
+        all.insert(all.end(), worker->snapshot.begin(), worker->snapshot.end());
+    }
+    return all;
+}
+
+bool TournamentServer::pollResult(SessionResult &result)
+{
+    for (std::size_t k = 0; k < workers.size(); ++k) {
+        std::size_t w = ((std::size_t)nextResult + k) % workers.size();
+        if (workers[w]->results.tryPop(result)) {
+            nextResult = (int)((w + 1) % workers.size());
+            return true;
+        }
+    }
+    return false;
+}
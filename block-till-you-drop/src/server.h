@@ -0,0 +1,207 @@
+#pragma once
+
+// Authoritative game server for leagues: many solo games in one process,
+// each stepped by the engine for one remote client.
+//
+// Clients speak the versus InputPacket over UDP. Joining takes two hellos
+// (packets with no inputs, ack and first 0). Hello with seed 0 from a new
+// address, and the server answers with a challenge: cols and rows 0, seed
+// a cookie derived from the address and a server secret, kept nowhere.
+// Echo the cookie as the seed of a second hello and the server opens a
+// session, answering with the real seed and board (the client's cols/rows
+// if it asked for a valid size, else the server's). So only an address
+// that can receive takes a slot, each IP may hold at most
+// maxSessionsPerIp of them, and a session that sends no input within
+// joinTimeoutMs is dropped. From then on
+// the client sends its inputs by tick and the server plays the game at
+// TICK_RATE on its own clock. It uses the client's input for a tick if it
+// has arrived, else the last one it applied, and sends back the inputs it
+// actually applied from the client's ack onwards. Since the engine is
+// deterministic, seed plus applied inputs let the client rebuild the
+// authoritative game exactly. Inputs for ticks already played are dropped.
+//
+// A client that stops acking (e.g. a network stall) is held once INPUT_RING
+// applied inputs, about 2 s, wait for its ack: its game stops stepping, and
+// catches up once acks resume. Only idleTimeoutMs without
+// any packet drops it.
+//
+// Threads: one receives datagrams and routes them; each of `workers` others
+// owns a fixed slab of sessions. A worker wakes once per tick and steps
+// every session it owns that is due, round-robin when catching up, so a
+// worker serves hundreds of games per wake instead of each game waiting on
+// its own timer. A session is a flat GameState plus fixed input rings, and
+// every slab is allocated once in start(): ticking never touches the heap
+// and workers never share a cache line of game state. Packets reach a
+// worker through a lock-free queue; workers send replies straight on the
+// shared socket.
+//
+// Per session the server tracks the engine time of each step and each
+// tick's latency: how long after it became due it was finished.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+#include "net.h"
+#include "rng.h"
+#include "spsc.h"
+#include "versus.h"
+
+// Histogram of durations in half-octave buckets from 1 ns: constant time
+// to add, percentiles good to about 20%.
+struct LatencyStats {
+    static const int BUCKETS = 64;
+
+    std::uint64_t count = 0;
+    double        totalUs = 0.0;
+    double        maxUs = 0.0;
+    std::uint32_t buckets[BUCKETS] = {};
+
+    void add(std::uint64_t ns);
+    void merge(const LatencyStats &other);
+    double meanUs() const { return count ? totalUs / (double)count : 0.0; }
+    // Upper edge of the bucket holding the p-th fraction, e.g. 0.99.
+    double percentileUs(double p) const;
+};
+
+struct ServerConfig {
+    std::uint16_t port        = 7777;
+    int           workers     = 1;
+    int           maxSessions = 256;        // across all workers, 1024 per worker at most
+    GameConfig    game;                     // board for clients that don't ask
+    int           sendEveryTicks = 4;       // 30 replies a second
+    int           idleTimeoutMs  = 10000;   // no packets: drop the session
+    int           lingerMs       = 2000;    // keep answering after game over
+    int           maxSessionsPerIp = 8;
+    int           joinTimeoutMs    = 1000;  // joined but no input yet: drop
+};
+
+// One session as last published by its worker.
+struct SessionMetrics {
+    NetAddress    client;
+    std::uint64_t seed;
+    std::uint32_t tick;
+    bool          gameOver;
+    std::uint64_t lateInputs;   // arrived after their tick was played
+    std::uint64_t heldInputs;   // ticks played on the previous input
+    LatencyStats  step;         // engine time per tick
+    LatencyStats  latency;      // due -> finished, per tick
+};
+
+// A game that ended or timed out, once its session closes.
+struct SessionResult {
+    NetAddress    client;
+    std::uint64_t seed;
+    std::uint16_t cols, rows;
+    float         survival;
+    int           rowsCleared;
+    int           powerupsUsed;
+    bool          finished;     // false if the client went quiet first
+    double        latencyP99Us;
+};
+
+class TournamentServer {
+public:
+    TournamentServer() = default;
+    ~TournamentServer();
+    TournamentServer(const TournamentServer &) = delete;
+    TournamentServer &operator=(const TournamentServer &) = delete;
+
+    // Bind the port and start the threads. False if the port is taken.
+    bool start(const ServerConfig &config);
+    // Stop and join every thread; live sessions are dropped.
+    void stop();
+    bool running() const { return !threads.empty(); }
+    // The config as start() applied it, with counts clamped to what fits.
+    const ServerConfig &config() const { return cfg; }
+
+    // Snapshot of every live session, refreshed by the workers once a
+    // second.
+    std::vector<SessionMetrics> metrics();
+    int liveSessions() const { return live.load(std::memory_order_relaxed); }
+    std::uint64_t ticksPlayed() const { return ticks.load(std::memory_order_relaxed); }
+    // Closed sessions whose results are waiting for room to be polled.
+    int resultsWaiting() const { return waiting.load(std::memory_order_relaxed); }
+
+    // Next closed session's result, if any. Call from one thread only.
+    // Results are never dropped: once a worker's queue of 256 is full, each
+    // further result waits in its session, which keeps its slot (and so a
+    // place among maxSessions) until there is room. Poll at least as often
+    // as sessions close, or resultsWaiting() grows and joins start failing.
+    bool pollResult(SessionResult &result);
+
+private:
+    static const int INPUT_RING = 256;      // ticks of inputs kept each way
+    static const int MAX_WORKER_SESSIONS = 1024;
+
+    enum SessionPhase {
+        SESSION_FREE, SESSION_PLAYING, SESSION_LINGERING,
+        SESSION_CLOSING                     // result waiting for room in `results`
+    };
+
+    struct alignas(64) Session {
+        SessionPhase  phase = SESSION_FREE;
+        NetAddress    client;
+        GameState     state;
+        std::uint64_t seed;
+        std::uint64_t startTick;            // server tick the game started on
+        std::uint32_t clientTicks;          // client inputs received, contiguous
+        std::uint32_t clientAck;            // applied inputs the client has
+        InputMask     clientInput[INPUT_RING];
+        InputMask     applied[INPUT_RING];
+        InputMask     held;
+        std::uint64_t lastHeardTick;
+        std::uint64_t nextReplyTick;
+        std::uint64_t endTick;              // when lingering ends
+        std::uint64_t lateInputs, heldInputs;
+        LatencyStats  step, latency;
+        SessionResult result;               // filled in by close()
+    };
+
+    struct Inbound {
+        int         slot;
+        bool        join;
+        NetAddress  from;
+        InputPacket packet;
+    };
+
+    struct Worker {
+        std::vector<Session> sessions;      // this worker's slab
+        int firstSlot = 0;
+        Rng seeds;
+        SpscQueue<Inbound, 1024> inbox;     // receive thread -> worker
+        // Worker -> receive thread. Holds a whole slab, so it is never full.
+        SpscQueue<int, MAX_WORKER_SESSIONS> closed;
+        SpscQueue<SessionResult, 256> results;
+        std::mutex published;
+        std::vector<SessionMetrics> snapshot;
+    };
+
+    void receiveLoop();
+    void workerLoop(int w);
+    void handle(Worker &worker, const Inbound &in, std::uint64_t serverTick);
+    void tickSession(Session &s);
+    void reply(Session &s);
+    void close(Worker &worker, int index, bool finished);
+    bool release(Worker &worker, int index);
+    void publish(Worker &worker);
+    std::uint64_t nowNs() const;
+    std::uint64_t joinCookie(const NetAddress &from, std::uint64_t period) const;
+
+    ServerConfig cfg;
+    UdpSocket    socket;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{ false };
+    std::atomic<int>  live{ 0 };
+    std::atomic<std::uint64_t> ticks{ 0 };
+    std::atomic<int>  waiting{ 0 };
+    std::chrono::steady_clock::time_point epoch;
+    std::uint64_t cookieSecret = 0;
+    int nextResult = 0;                     // worker pollResult() looks at first
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+// Bounded single-producer single-consumer ring. Neither side ever locks or
+// waits: a push onto a full ring or a pop from an empty one just fails, so
+// the frame loop can hand work to a background thread at no risk of
+// stalling.
+
+#include <atomic>
+#include <cstddef>
+
+template <class T, std::size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // Producer side only.
+    bool tryPush(const T &item) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only.
+    bool tryPop(T &item) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Each index on its own cache line, so the two threads don't share one.
+    alignas(64) std::atomic<std::size_t> head{ 0 };
+    alignas(64) std::atomic<std::size_t> tail{ 0 };
+    T slots[N];
+};
@@ -0,0 +1,145 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "net.h"
+
+static const char          TELEMETRY_MAGIC[4] = { 'B', 'T', 'T', 'M' };
+static const std::uint16_t TELEMETRY_VERSION  = 1;
+static const int           SEND_TIMEOUT_MS    = 2000;
+static const int           MAX_BACKOFF_MS     = 60000;
+
+static void putVarint(std::vector<std::uint8_t> &out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back((std::uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((std::uint8_t)v);
+}
+
+// Non-negative quantity in fixed steps, e.g. microseconds in 0.1 us units.
+static std::uint64_t quantize(double v, double scale)
+{
+    return v > 0 ? (std::uint64_t)(v * scale + 0.5) : 0;
+}
+
+static void putLE(std::uint8_t *out, std::uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) out[i] = (std::uint8_t)(v >> (8 * i));
+}
+
+std::vector<std::uint8_t> encodeReportBatch(const GameReport *reports, int count)
+{
+    const std::size_t HEADER = 12;
+    std::vector<std::uint8_t> out(HEADER);
+    for (int i = 0; i < count; ++i) {
+        const GameReport &r = reports[i];
+        putVarint(out, r.when);
+        putVarint(out, r.seed);
+        putVarint(out, r.cols);
+        putVarint(out, r.rows);
+        putVarint(out, quantize(r.survival, 1000.0));
+        putVarint(out, (std::uint64_t)std::max(r.rowsCleared, 0));
+        putVarint(out, (std::uint64_t)std::max(r.powerupsUsed, 0));
+        putVarint(out, quantize(r.frameAvgUs, 10.0));
+        for (const PhaseStats &p : r.phases) {
+            putVarint(out, quantize(p.avgUs, 10.0));
+            putVarint(out, quantize(p.p99Us, 10.0));
+        }
+        const void *nul = std::memchr(r.player, 0, sizeof(r.player));
+        std::size_t len = nul ? (std::size_t)((const char *)nul - r.player) : sizeof(r.player);
+        putVarint(out, len);
+        out.insert(out.end(), r.player, r.player + len);
+    }
+    std::memcpy(out.data(), TELEMETRY_MAGIC, 4);
+    putLE(out.data() + 4, TELEMETRY_VERSION, 2);
+    putLE(out.data() + 6, (std::uint64_t)count, 2);
+    putLE(out.data() + 8, out.size() - HEADER, 4);
+    return out;
+}
+
+TelemetryUploader::~TelemetryUploader()
+{
+    stop();
+}
+
+void TelemetryUploader::start(const char *host_, std::uint16_t port_)
+{
+    if (running()) return;
+    host = host_;
+    port = port_;
+    stopping.store(false);
+    worker = std::thread(&TelemetryUploader::run, this);
+}
+
+bool TelemetryUploader::submit(const GameReport &report)
+{
+    return running() && queue.tryPush(report);
+}
+
+void TelemetryUploader::stop()
+{
+    if (!running()) return;
+    stopping.store(true, std::memory_order_release);
+    worker.join();
+}
+
+// Send pending reports a batch at a time, oldest first, removing each batch
+// that went out. False at the first failed send.
+bool TelemetryUploader::flush(std::vector<GameReport> &pending)
+{
+    std::size_t sent = 0;
+    bool ok = true;
+    while (sent < pending.size()) {
+        int count = (int)std::min<std::size_t>(pending.size() - sent, MAX_BATCH);
+        std::vector<std::uint8_t> batch = encodeReportBatch(pending.data() + sent, count);
+        if (!sendOverTcp(host.c_str(), port, batch.data(), batch.size(), SEND_TIMEOUT_MS)) {
+            ok = false;
+            break;
+        }
+        sent += (std::size_t)count;
+    }
+    pending.erase(pending.begin(), pending.begin() + (std::ptrdiff_t)sent);
+    return ok;
+}
+
+void TelemetryUploader::run()
+{
+    typedef std::chrono::steady_clock Clock;
+    std::vector<GameReport> pending;
+    Clock::time_point oldest, retryAt;
+    int backoffMs = 1000;
+
+    for (;;) {
+        bool last = stopping.load(std::memory_order_acquire);
+        Clock::time_point now = Clock::now();
+
+        GameReport report;
+        while (queue.tryPop(report)) {
+            if (pending.empty()) oldest = now;
+            pending.push_back(report);
+        }
+        // While the server is unreachable, the newest reports win.
+        if (pending.size() > (std::size_t)MAX_PENDING)
+            pending.erase(pending.begin(), pending.end() - MAX_PENDING);
+
+        bool due = !pending.empty() &&
+                   (last || (now >= retryAt &&
+                             ((int)pending.size() >= MAX_BATCH ||
+                              now - oldest >= std::chrono::milliseconds(FLUSH_AFTER_MS))));
+        if (due) {
+            if (flush(pending)) {
+                backoffMs = 1000;
+            } else {
+                retryAt = now + std::chrono::milliseconds(backoffMs);
+                backoffMs = std::min(2 * backoffMs, MAX_BACKOFF_MS);
+            }
+            oldest = now;
+        }
+        if (last) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
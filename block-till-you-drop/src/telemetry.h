@@ -0,0 +1,76 @@
+#pragma once
+
+// Game results shipped to a collection server without touching the frame
+// loop. submit() copies a report into a lock-free queue and returns; a
+// worker thread drains it, packs reports into batches and sends each batch
+// over TCP. A batch goes out once it is full or its oldest report has
+// waited FLUSH_AFTER_MS; failed sends are retried with backoff, keeping at
+// most MAX_PENDING reports.
+//
+// Batch layout (little-endian):
+//   "BTTM"  magic
+//   u16     format version
+//   u16     report count
+//   u32     size of the packed reports that follow
+//   reports, each as LEB128 varints:
+//     when (s since the epoch), seed, cols, rows,
+//     survival time (ms), rows cleared, powerups used,
+//     frame average (0.1 us), then per ProfPhase: average, p99 (0.1 us)
+//     player name: length, then the bytes
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "profiler.h"
+#include "spsc.h"
+
+struct GameReport {
+    std::uint64_t when;                // seconds since the Unix epoch
+    std::uint64_t seed;
+    std::uint16_t cols, rows;
+    float         survival;            // seconds
+    int           rowsCleared;
+    int           powerupsUsed;
+    float         frameAvgUs;          // over the last Profiler::HISTORY frames
+    PhaseStats    phases[PHASE_COUNT];
+    char          player[16];          // NUL-terminated
+};
+
+class TelemetryUploader {
+public:
+    static constexpr int MAX_BATCH      = 32;
+    static constexpr int MAX_PENDING    = 256;
+    static constexpr int FLUSH_AFTER_MS = 10000;
+
+    TelemetryUploader() = default;
+    ~TelemetryUploader();
+    TelemetryUploader(const TelemetryUploader &) = delete;
+    TelemetryUploader &operator=(const TelemetryUploader &) = delete;
+
+    // Start the worker, sending to host:port.
+    void start(const char *host, std::uint16_t port);
+    bool running() const { return worker.joinable(); }
+
+    // From the frame loop. Never blocks; false if the queue is full and the
+    // report was dropped.
+    bool submit(const GameReport &report);
+
+    // Stop the worker after one last attempt at whatever is still queued.
+    void stop();
+
+private:
+    void run();
+    bool flush(std::vector<GameReport> &pending);
+
+    std::string   host;
+    std::uint16_t port = 0;
+    std::thread   worker;
+    std::atomic<bool> stopping{ false };
+    SpscQueue<GameReport, 64> queue;
+};
+
+// One batch in the layout above.
+std::vector<std::uint8_t> encodeReportBatch(const GameReport *reports, int count);
@@ -0,0 +1,298 @@
+// Standalone tournament server: runs a TournamentServer until interrupted
+// (or for --seconds), with no window or renderer.
+//
+//   tournament [--port P] [--workers N] [--sessions N] [--per-ip N]
+//              [--board COLSxROWS] [--metrics SEC] [--seconds SEC]
+//   tournament --client HOST:PORT [--games N] [--board COLSxROWS] [--seconds SEC]
+//
+// Prints one CSV line per closed session (client, seed, board, survival,
+// rows cleared, powerups used, finished, p99 tick latency) to stdout, and
+// every --metrics seconds (default 5, 0 for never) a summary to stderr:
+// live sessions, results not yet collected, ticks per second and the worst
+// session's p99 tick latency and engine step time. Workers default to one
+// per core, leaving one for the receive thread.
+// --per-ip caps the sessions one client IP may hold at once (default 8).
+//
+// --client is the other end, for load tests and for checking the server:
+// it plays N games at once (default 16), each from its own socket, with the
+// headless runner's random stand-in player. Every game is rebuilt locally
+// from its seed and the inputs the server says it applied, and printed as
+// seed, board, survival, rows cleared and powerups used once it ends:
+// columns 2-6 of the server's lines for finished games, so the two sorted
+// lists must be identical. The summary on stderr counts the ticks the
+// server played on a different input than was sent. Run it for --seconds
+// (default 120) at most. One host only gets --per-ip sessions at a time.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "input.h"
+#include "parallel.h"
+#include "rng.h"
+#include "server.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: tournament [--port P] [--workers N] [--sessions N] [--per-ip N]\n"
+        "                  [--board COLSxROWS] [--metrics SEC] [--seconds SEC]\n"
+        "       tournament --client HOST:PORT [--games N] [--board COLSxROWS] [--seconds SEC]\n");
+}
+
+static void printResult(const SessionResult &r)
+{
+    std::printf("%u.%u.%u.%u:%u,%llu,%ux%u,%.3f,%d,%d,%d,%.1f\n",
+                (unsigned)(r.client.ip >> 24), (unsigned)(r.client.ip >> 16) & 0xff,
+                (unsigned)(r.client.ip >> 8) & 0xff, (unsigned)r.client.ip & 0xff,
+                (unsigned)r.client.port, (unsigned long long)r.seed,
+                (unsigned)r.cols, (unsigned)r.rows, r.survival, r.rowsCleared,
+                r.powerupsUsed, r.finished ? 1 : 0, r.latencyP99Us);
+    std::fflush(stdout);
+}
+
+static void printMetrics(TournamentServer &server, std::uint64_t ticks, double sec)
+{
+    double worstLatency = 0.0, worstStep = 0.0;
+    std::uint64_t late = 0, held = 0;
+    for (const SessionMetrics &m : server.metrics()) {
+        worstLatency = std::max(worstLatency, m.latency.percentileUs(0.99));
+        worstStep = std::max(worstStep, m.step.percentileUs(0.99));
+        late += m.lateInputs;
+        held += m.heldInputs;
+    }
+    std::fprintf(stderr,
+                 "%d live, %d results waiting, %.0f ticks/s, worst p99: latency %.1f us, "
+                 "step %.1f us; %llu late / %llu held inputs\n",
+                 server.liveSessions(), server.resultsWaiting(), sec > 0.0 ? (double)ticks / sec : 0.0,
+                 worstLatency, worstStep, (unsigned long long)late, (unsigned long long)held);
+}
+
+// "host:port" into its parts; false without a valid port.
+static bool splitHostPort(const char *addr, std::string &host, std::uint16_t &port)
+{
+    host = addr;
+    std::size_t colon = host.rfind(':');
+    if (colon == std::string::npos) return false;
+    int p = std::atoi(host.c_str() + colon + 1);
+    host.resize(colon);
+    port = (std::uint16_t)p;
+    return p > 0 && p <= 65535;
+}
+
+// One remote game as the client sees it.
+struct LeagueClient {
+    UdpPeer       peer;
+    bool          joined = false, done = false;
+    std::uint64_t cookie = 0;           // from the server's challenge
+    std::uint64_t seed = 0;
+    Clock::time_point joinedAt, lastHello;
+    Rng           rng;
+    InputMask     input = 0;
+    int           holdTicks = 0;
+    std::vector<InputMask> sent;        // by tick
+    std::vector<InputMask> applied;     // by tick, as the server played them
+    std::uint32_t serverHas = 0;        // sent inputs the server has acked
+    GameState     state;                // rebuilt from the applied inputs
+};
+
+// Inputs are sent this far ahead of the client's clock, to cover the trip.
+static const int CLIENT_LEAD_TICKS = 12;
+
+static void clientReceive(LeagueClient &c)
+{
+    std::uint8_t buf[MAX_PACKET_SIZE];
+    int n;
+    while ((n = c.peer.receive(buf, sizeof(buf))) >= 0) {
+        InputPacket p;
+        if (!decodeInputPacket(buf, (std::size_t)n, p)) continue;
+        if (p.cols == 0) {              // challenge: echo it in the next hello
+            if (!c.joined) c.cookie = p.seed;
+            continue;
+        }
+        if (!c.joined) {
+            c.joined = true;
+            c.seed = p.seed;
+            c.joinedAt = Clock::now();
+            c.state.config.cols = p.cols;
+            c.state.config.rows = p.rows;
+            resetGame(c.state, c.seed);
+        }
+        c.serverHas = std::max(c.serverHas, std::min(p.ack, (std::uint32_t)c.sent.size()));
+        if (p.first > c.applied.size()) continue;
+        for (std::uint32_t t = (std::uint32_t)c.applied.size(); t < p.first + (std::uint32_t)p.count; ++t)
+            c.applied.push_back(p.inputs[t - p.first]);
+    }
+}
+
+static void clientSend(LeagueClient &c, int askCols, int askRows)
+{
+    InputPacket p = {};
+    p.cols = (std::uint16_t)askCols;
+    p.rows = (std::uint16_t)askRows;
+    if (!c.joined) {
+        Clock::time_point now = Clock::now();
+        if (now - c.lastHello < std::chrono::milliseconds(100)) return;
+        c.lastHello = now;
+        p.seed = c.cookie;
+    } else {
+        std::size_t due = (std::size_t)(std::chrono::duration<double>(
+            Clock::now() - c.joinedAt).count() * TICK_RATE) + CLIENT_LEAD_TICKS;
+        while (c.sent.size() < due) {
+            if (--c.holdTicks <= 0) {
+                c.input = randomInput(c.rng);
+                c.holdTicks = TICK_RATE / 4;
+            }
+            c.sent.push_back(c.input);
+        }
+        p.ack = (std::uint32_t)c.applied.size();
+        p.first = c.serverHas;
+        p.count = (int)std::min<std::size_t>(c.sent.size() - c.serverHas, InputPacket::MAX_INPUTS);
+        for (int k = 0; k < p.count; ++k) p.inputs[k] = c.sent[p.first + (std::uint32_t)k];
+    }
+    std::uint8_t buf[MAX_PACKET_SIZE];
+    c.peer.send(buf, encodeInputPacket(p, buf));
+}
+
+static int runClients(const char *addr, int games, int askCols, int askRows, double runSec)
+{
+    std::string host;
+    std::uint16_t port;
+    if (!splitHostPort(addr, host, port)) { usage(); return 1; }
+    std::vector<LeagueClient> clients((std::size_t)std::max(games, 1));
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        if (!clients[i].peer.join(host.c_str(), port)) {
+            std::fprintf(stderr, "cannot reach %s\n", addr);
+            return 1;
+        }
+        clients[i].rng.seed(mixSeed(i + 1), 0xc11e);
+    }
+    if (runSec <= 0.0) runSec = 120.0;
+
+    std::printf("seed,board,survival,rows_cleared,powerups_used\n");
+    const Clock::time_point t0 = Clock::now();
+    std::size_t finished = 0;
+    std::uint64_t ticks = 0, changed = 0;
+    while (!interrupted && finished < clients.size() &&
+           std::chrono::duration<double>(Clock::now() - t0).count() < runSec) {
+        for (LeagueClient &c : clients) {
+            if (c.done) continue;
+            clientReceive(c);
+            while (c.state.tick < c.applied.size() && !c.state.gameOver)
+                step(c.state, c.applied[c.state.tick], TICK_DT);
+            if (c.joined && c.state.gameOver) {
+                // Ack the last inputs so the server can close straight away.
+                c.serverHas = (std::uint32_t)c.sent.size();
+                clientSend(c, askCols, askRows);
+                for (std::uint32_t t = 0; t < c.state.tick && t < c.sent.size(); ++t)
+                    changed += c.sent[t] != c.applied[t];
+                ticks += c.state.tick;
+                std::printf("%llu,%dx%d,%.3f,%d,%d\n", (unsigned long long)c.seed,
+                            c.state.config.cols, c.state.config.rows, c.state.elapsedTime,
+                            c.state.stats.rowsCleared, c.state.stats.powerupsUsed);
+                std::fflush(stdout);
+                c.done = true;
+                ++finished;
+                continue;
+            }
+            clientSend(c, askCols, askRows);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+    }
+
+    double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::fprintf(stderr, "%zu/%zu games finished in %.1f s; %llu of %llu ticks played on "
+                 "another input than sent\n", finished, clients.size(), wall,
+                 (unsigned long long)changed, (unsigned long long)ticks);
+    return finished == clients.size() ? 0 : 1;
+}
+
+static int runServer(const ServerConfig &cfg, double metricsSec, double runSec)
+{
+    TournamentServer server;
+    if (!server.start(cfg)) {
+        std::fprintf(stderr, "cannot listen on UDP port %u\n", (unsigned)cfg.port);
+        return 1;
+    }
+    std::fprintf(stderr, "listening on UDP port %u, %d workers, up to %d sessions\n",
+                 (unsigned)cfg.port, server.config().workers, server.config().maxSessions);
+    std::printf("client,seed,board,survival,rows_cleared,powerups_used,finished,latency_p99_us\n");
+
+    const Clock::time_point t0 = Clock::now();
+    Clock::time_point lastReport = t0;
+    std::uint64_t lastTicks = 0;
+
+    while (!interrupted) {
+        SessionResult r;
+        while (server.pollResult(r)) printResult(r);
+
+        Clock::time_point now = Clock::now();
+        if (runSec > 0.0 && std::chrono::duration<double>(now - t0).count() >= runSec) break;
+        double since = std::chrono::duration<double>(now - lastReport).count();
+        if (metricsSec > 0.0 && since >= metricsSec) {
+            std::uint64_t ticks = server.ticksPlayed();
+            printMetrics(server, ticks - lastTicks, since);
+            lastTicks = ticks;
+            lastReport = now;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // Report what finished while shutting down the loop, then drop the rest.
+    SessionResult r;
+    while (server.pollResult(r)) printResult(r);
+    server.stop();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    ServerConfig cfg;
+    cfg.workers = std::max(defaultThreadCount() - 1, 1);
+    double metricsSec = 5.0;
+    double runSec = 0.0;
+    const char *clientAddr = nullptr;
+    int games = 16;
+    int askCols = 0, askRows = 0;       // 0: the server's board
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!v) { usage(); return 1; }
+        if      (std::strcmp(a, "--port") == 0)     cfg.port = (std::uint16_t)std::atoi(v);
+        else if (std::strcmp(a, "--workers") == 0)  cfg.workers = std::atoi(v);
+        else if (std::strcmp(a, "--sessions") == 0) cfg.maxSessions = std::atoi(v);
+        else if (std::strcmp(a, "--per-ip") == 0)   cfg.maxSessionsPerIp = std::atoi(v);
+        else if (std::strcmp(a, "--metrics") == 0)  metricsSec = std::atof(v);
+        else if (std::strcmp(a, "--seconds") == 0)  runSec = std::atof(v);
+        else if (std::strcmp(a, "--client") == 0)   clientAddr = v;
+        else if (std::strcmp(a, "--games") == 0)    games = std::atoi(v);
+        else if (std::strcmp(a, "--board") == 0) {
+            if (std::sscanf(v, "%dx%d", &askCols, &askRows) != 2) { usage(); return 1; }
+            cfg.game.cols = askCols;
+            cfg.game.rows = askRows;
+        }
+        else { usage(); return 1; }
+        ++i;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    if (clientAddr) return runClients(clientAddr, games, askCols, askRows, runSec);
+    return runServer(cfg, metricsSec, runSec);
+}
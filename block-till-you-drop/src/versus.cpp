@@ -0,0 +1,175 @@
+#include "versus.h"
+
+#include <algorithm>
+#include <cstring>
+
+void resetVersus(VersusState &vs, const GameConfig &config, std::uint64_t seed)
+{
+    for (GameState &b : vs.board) {
+        b.config = config;
+        resetGame(b, seed);
+    }
+    vs.garbageRng.seed(seed, 0x6a7b);
+    vs.tick = 0;
+    vs.winner = -1;
+}
+
+bool stepVersus(VersusState &vs, InputMask input0, InputMask input1)
+{
+    ++vs.tick;
+    const InputMask input[2] = { input0, input1 };
+    int cleared[2];
+    for (int p = 0; p < 2; ++p) {
+        int before = vs.board[p].stats.rowsCleared;
+        step(vs.board[p], input[p], TICK_DT);
+        cleared[p] = vs.board[p].stats.rowsCleared - before;
+    }
+    // Sent after both boards stepped, so neither side's order matters.
+    for (int p = 0; p < 2; ++p)
+        if (cleared[p] > 0) {
+            GameState &target = vs.board[1 - p];
+            addGarbage(target, cleared[p], vs.garbageRng.below(target.grid.width));
+        }
+
+    if (vs.winner >= 0) return false;
+    bool over0 = vs.board[0].gameOver, over1 = vs.board[1].gameOver;
+    if (!over0 && !over1) return false;
+    vs.winner = (over0 && over1) ? 2 : over0 ? 1 : 0;
+    return true;
+}
+
+static void copyVersusState(VersusState &dst, const VersusState &src)
+{
+    copyGameState(dst.board[0], src.board[0]);
+    copyGameState(dst.board[1], src.board[1]);
+    dst.garbageRng = src.garbageRng;
+    dst.tick       = src.tick;
+    dst.winner     = src.winner;
+}
+
+void RollbackSession::start(int localSide, const GameConfig &config, std::uint64_t seed)
+{
+    side = localSide;
+    matchSeed = seed;
+    resetVersus(predicted, config, seed);
+    confirmedTicks = 0;
+    inputs[0].clear();
+    inputs[1].clear();
+    guessed.clear();
+    rollbackCount = 0;
+}
+
+bool RollbackSession::canAdvance() const
+{
+    return started() && predicted.tick - confirmedTicks < (std::uint32_t)MAX_PREDICTION;
+}
+
+const VersusState &RollbackSession::confirmedState() const
+{
+    return confirmedTicks == predicted.tick ? predicted : history[confirmedTicks % HISTORY];
+}
+
+InputMask RollbackSession::remoteFor(std::uint32_t tick) const
+{
+    const std::vector<InputMask> &remote = inputs[1 - side];
+    if (tick < remote.size()) return remote[tick];
+    return remote.empty() ? 0 : remote.back();
+}
+
+void RollbackSession::stepWith(VersusState &vs, InputMask local, InputMask remote)
+{
+    if (side == 0) stepVersus(vs, local, remote);
+    else           stepVersus(vs, remote, local);
+}
+
+void RollbackSession::advance(InputMask local)
+{
+    std::uint32_t t = predicted.tick;
+    InputMask remote = remoteFor(t);
+    inputs[side].push_back(local);
+    guessed.push_back(remote);
+    copyVersusState(history[t % HISTORY], predicted);
+    stepWith(predicted, local, remote);
+}
+
+void RollbackSession::addRemoteInputs(std::uint32_t first, const InputMask *masks, int count)
+{
+    std::vector<InputMask> &remote = inputs[1 - side];
+    if (first > remote.size()) return;
+    // The opponent waits once it is MAX_PREDICTION ticks past what it has
+    // from us, so anything beyond that is not a peer playing by the rules.
+    std::size_t limit = inputs[side].size() + MAX_PREDICTION;
+    for (int i = (int)(remote.size() - first); i < count && remote.size() < limit; ++i)
+        remote.push_back(masks[i]);
+}
+
+void RollbackSession::sync()
+{
+    if (!started()) return;
+    const std::vector<InputMask> &local = inputs[side], &remote = inputs[1 - side];
+
+    // Ticks whose guess was right need no work: the prediction already
+    // stepped them with the real inputs.
+    std::uint32_t wrong = UINT32_MAX;
+    for (; confirmedTicks < local.size() && confirmedTicks < remote.size(); ++confirmedTicks)
+        if (wrong == UINT32_MAX && guessed[confirmedTicks] != remote[confirmedTicks])
+            wrong = confirmedTicks;
+    if (wrong == UINT32_MAX) return;
+
+    // Nothing from the first wrong guess on can be trusted: restore the
+    // state from before it and replay the local inputs with fresh guesses.
+    ++rollbackCount;
+    std::uint32_t target = predicted.tick;
+    copyVersusState(predicted, history[wrong % HISTORY]);
+    for (std::uint32_t t = wrong; t < target; ++t) {
+        if (t != wrong) copyVersusState(history[t % HISTORY], predicted);
+        guessed[t] = remoteFor(t);
+        stepWith(predicted, local[t], guessed[t]);
+    }
+}
+
+static const char VERSUS_MAGIC[4] = { 'B', 'T', 'V', 'S' };
+
+static std::uint8_t *putLE(std::uint8_t *out, std::uint64_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) *out++ = (std::uint8_t)(v >> (8 * i));
+    return out;
+}
+
+static std::uint64_t getLE(const std::uint8_t *in, int bytes)
+{
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= (std::uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+std::size_t encodeInputPacket(const InputPacket &packet, std::uint8_t *out)
+{
+    int count = std::max(0, std::min(packet.count, InputPacket::MAX_INPUTS));
+    std::uint8_t *p = out;
+    std::memcpy(p, VERSUS_MAGIC, 4);
+    p = putLE(p + 4, packet.seed, 8);
+    p = putLE(p, packet.cols, 2);
+    p = putLE(p, packet.rows, 2);
+    p = putLE(p, packet.ack, 4);
+    p = putLE(p, packet.first, 4);
+    *p++ = (std::uint8_t)count;
+    std::memcpy(p, packet.inputs, (std::size_t)count);
+    return (std::size_t)(p - out) + (std::size_t)count;
+}
+
+bool decodeInputPacket(const std::uint8_t *data, std::size_t size, InputPacket &packet)
+{
+    const std::size_t HEADER = 4 + 8 + 2 + 2 + 4 + 4 + 1;
+    if (size < HEADER || std::memcmp(data, VERSUS_MAGIC, 4) != 0) return false;
+    packet.seed  = getLE(data + 4, 8);
+    packet.cols  = (std::uint16_t)getLE(data + 12, 2);
+    packet.rows  = (std::uint16_t)getLE(data + 14, 2);
+    packet.ack   = (std::uint32_t)getLE(data + 16, 4);
+    packet.first = (std::uint32_t)getLE(data + 20, 4);
+    packet.count = data[24];
+    if (packet.count > InputPacket::MAX_INPUTS || size != HEADER + (std::size_t)packet.count)
+        return false;
+    std::memcpy(packet.inputs, data + HEADER, (std::size_t)packet.count);
+    return true;
+}
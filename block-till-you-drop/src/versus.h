@@ -0,0 +1,100 @@
+#pragma once
+
+// Two-player versus: both boards stepped together, rows one player clears
+// rising as garbage on the other's. Peers keep the match in sync by
+// exchanging only their per-tick input masks; RollbackSession predicts the
+// opponent's input, runs ahead, and on a wrong prediction restores the
+// state from before that tick and re-simulates. No SDL, like the engine.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "game.h"
+#include "rng.h"
+
+struct VersusState {
+    GameState     board[2];
+    Rng           garbageRng;    // hole columns, so boards keep their own spawn streams
+    std::uint32_t tick;
+    int           winner;        // -1 while playing, 0 or 1, 2 for a draw
+};
+
+// Both boards get the same seed, so they see the same pieces.
+void resetVersus(VersusState &vs, const GameConfig &config, std::uint64_t seed);
+
+// One tick of both boards. Returns true on the tick the match ends.
+bool stepVersus(VersusState &vs, InputMask input0, InputMask input1);
+
+class RollbackSession {
+public:
+    // How far the local side may run ahead of the last tick both inputs are
+    // known for; beyond that it waits for the opponent. 100 ms at 120 Hz.
+    static const int MAX_PREDICTION = 12;
+    // States kept from before each of the last HISTORY ticks, so any tick
+    // still inside the prediction window can be rolled back to.
+    static const int HISTORY = 16;
+    static_assert(MAX_PREDICTION < HISTORY, "rollback target must still be in the history");
+
+    void start(int localSide, const GameConfig &config, std::uint64_t seed);
+    bool started() const { return side >= 0; }
+    int  localSide() const { return side; }
+    std::uint64_t seed() const { return matchSeed; }
+
+    bool canAdvance() const;
+    // Run the displayed state one tick with this input, guessing the
+    // opponent's as their last known one.
+    void advance(InputMask local);
+
+    // Opponent inputs for ticks [first, first + count); ranges overlapping
+    // what is already known are fine, ones leaving a gap are ignored, and
+    // nothing past MAX_PREDICTION ticks beyond the local tick is kept.
+    void addRemoteInputs(std::uint32_t first, const InputMask *masks, int count);
+
+    // Confirm every tick both inputs are now known for, rolling the
+    // displayed state back to the first wrong guess if there was one.
+    void sync();
+
+    const VersusState &view() const { return predicted; }
+    // The state after the last confirmed tick.
+    const VersusState &confirmedState() const;
+
+    std::uint32_t localTicks() const  { return (std::uint32_t)inputs[side].size(); }
+    std::uint32_t remoteTicks() const { return (std::uint32_t)inputs[1 - side].size(); }
+    const InputMask *localInputs() const { return inputs[side].data(); }
+    std::uint64_t rollbacks() const { return rollbackCount; }
+
+private:
+    InputMask remoteFor(std::uint32_t tick) const;
+    void stepWith(VersusState &vs, InputMask local, InputMask remote);
+
+    int side = -1;
+    std::uint64_t matchSeed = 0;
+    VersusState predicted;
+    std::uint32_t confirmedTicks = 0;
+    VersusState history[HISTORY];        // history[t % HISTORY]: before tick t
+    std::vector<InputMask> inputs[2];    // by tick, as known
+    std::vector<InputMask> guessed;      // opponent input the prediction used, by tick
+    std::uint64_t rollbackCount = 0;
+};
+
+// Wire format of the one packet type, sent every frame: the session
+// parameters (so the joining side can start), what the sender has heard
+// from its peer, and the sender's inputs from the first tick the peer is
+// missing on. Resending unacknowledged inputs each frame covers packet loss.
+struct InputPacket {
+    static const int MAX_INPUTS = 4 * RollbackSession::MAX_PREDICTION;
+
+    std::uint64_t seed;
+    std::uint16_t cols, rows;
+    std::uint32_t ack;           // opponent ticks received
+    std::uint32_t first;         // tick of inputs[0]
+    int           count;
+    InputMask     inputs[MAX_INPUTS];
+};
+
+static const std::size_t MAX_PACKET_SIZE = 32 + InputPacket::MAX_INPUTS;
+
+// Returns the encoded size.
+std::size_t encodeInputPacket(const InputPacket &packet, std::uint8_t *out);
+bool decodeInputPacket(const std::uint8_t *data, std::size_t size, InputPacket &packet);